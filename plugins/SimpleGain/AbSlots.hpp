@@ -0,0 +1,107 @@
+/**
+ * A/B comparison slots of parameter values
+ *
+ * The active slot is the live parameters, which are kept outside; the
+ * other slots hold the values which were live when they were left. To
+ * select a slot is to store the live values into the active one and take
+ * those of the selected one in their place. A slot selected for the first
+ * time starts as a copy of the live values, so that a comparison starts
+ * from the settings being compared.
+ *
+ * The DSP and the UI each keep a copy, which follow each other as long as
+ * they see the same selections from the same values; the session state
+ * carries the slots, as the contents of one field.
+ */
+
+#ifndef AB_SLOTS_H
+#define AB_SLOTS_H
+
+#include "SessionState.hpp"
+#include <stdint.h>
+#include <string.h>
+
+template <uint32_t Columns, uint32_t Slots>
+class AbSlots {
+public:
+    static_assert(Slots >= 2 && Slots <= 32, "the slots in use are a mask of 32 bits");
+
+    enum {
+        kColumns = Columns,
+        kSlots = Slots,
+    };
+
+    AbSlots() { reset(); }
+
+    void reset() {
+        memset(fRows, 0, sizeof(fRows));
+        fActive = 0;
+        fUsed = 1;
+    }
+
+    uint32_t getActive() const { return fActive; }
+    const float* getSlot(uint32_t slot) const { return fRows[slot]; }
+
+    /**
+      Select a slot, given the kColumns live values. Returns the values to
+      make live, or null if the slot is already active or does not exist.
+    */
+    const float* select(uint32_t slot, const float* live) {
+        if (slot == fActive || slot >= kSlots)
+            return nullptr;
+        memcpy(fRows[fActive], live, sizeof(fRows[0]));
+        if (!(fUsed & (1u << slot))) {
+            memcpy(fRows[slot], live, sizeof(fRows[0]));
+            fUsed |= 1u << slot;
+        }
+        fActive = slot;
+        return fRows[slot];
+    }
+
+    /**
+      Write the contents of a field: the active slot, the mask of the slots
+      in use, the slot count and the values of every slot, those of the
+      active one being the live values.
+    */
+    void write(StateWriter& writer, const float* live) const {
+        writer.writeVarint(fActive);
+        writer.writeVarint(fUsed);
+        writer.writeVarint(kSlots);
+        for (uint32_t s = 0; s < kSlots; ++s) {
+            const float* const row = (s == fActive) ? live : fRows[s];
+            for (uint32_t c = 0; c < kColumns; ++c)
+                writer.writeFloat(row[c]);
+        }
+    }
+
+    /**
+      Read the contents of a field; the live values are left to the caller.
+      Changes nothing and returns false if the field is not valid.
+    */
+    bool read(StateReader& field) {
+        uint32_t active, used, count;
+        if (!field.readVarint(active) || !field.readVarint(used) || !field.readVarint(count))
+            return false;
+        if (active >= kSlots || count != kSlots)
+            return false;
+
+        float rows[kSlots][kColumns];
+        for (uint32_t s = 0; s < kSlots; ++s) {
+            for (uint32_t c = 0; c < kColumns; ++c) {
+                if (!field.readFloat(rows[s][c]))
+                    return false;
+            }
+        }
+
+        memcpy(fRows, rows, sizeof(fRows));
+        fActive = active;
+        fUsed = (used | (1u << active)) & (uint32_t)((1ull << kSlots) - 1);
+        return true;
+    }
+
+private:
+    float fRows[kSlots][kColumns];
+    uint32_t fActive;
+    uint32_t fUsed;  // a bit per slot which was selected once
+};
+
+#endif  // #ifndef AB_SLOTS_H
@@ -24,12 +24,17 @@ public:
     void setSampleRate(float samplingRate) {
         if (samplingRate != fs) {
             fs = samplingRate;
-            a = exp(-TWO_PI / (t * 0.001f * samplingRate));
+            a = pole(t, samplingRate);
             b = 1.0f - a;
             z = 0.0f;
         }
     }
 
+    // feedback coefficient for a smoothing time
+    static float pole(float smoothingTimeMs, float samplingRate) {
+        return exp(-TWO_PI / (smoothingTimeMs * 0.001f * samplingRate));
+    }
+
     inline float process(float in) {
         return z = (in * b) + (z * a);
     }
@@ -35,11 +35,18 @@
 #define DISTRHO_UI_USE_NANOVG        0
 #define DISTRHO_UI_USER_RESIZABLE    1
 
+// the editor keeps its size in the plugin, for the session state; LV2 hosts
+// need the instance-access feature to show it
+#define DISTRHO_PLUGIN_WANT_DIRECT_ACCESS 1
+
 #define DISTRHO_PLUGIN_IS_RT_SAFE       1
 #define DISTRHO_PLUGIN_NUM_INPUTS       2
 #define DISTRHO_PLUGIN_NUM_OUTPUTS      2
+#define DISTRHO_PLUGIN_WANT_LATENCY     1
 #define DISTRHO_PLUGIN_WANT_TIMEPOS     0
 #define DISTRHO_PLUGIN_WANT_PROGRAMS    1
+#define DISTRHO_PLUGIN_WANT_STATE       1
+#define DISTRHO_PLUGIN_WANT_FULL_STATE  1
 #define DISTRHO_PLUGIN_WANT_MIDI_INPUT  0
 #define DISTRHO_PLUGIN_WANT_MIDI_OUTPUT 0
 
@@ -0,0 +1,191 @@
+/**
+ * DSP load meter with a high-dynamic-range histogram
+ *
+ * Each processing block is timed, and its cost per frame is counted in a
+ * log-linear histogram: exact below 64, then 32 buckets per octave, which
+ * keeps the relative error under 3% over the whole 32-bit range. The load
+ * is that cost as a fraction of the realtime budget of a frame.
+ *
+ * The time is read with rdtsc on x86 and the monotonic clock elsewhere.
+ * The tick rate is measured against the monotonic clock, over the time
+ * since the last reset, when a summary is computed; recording does not
+ * need it. Recording one block costs two tick reads, a division and a
+ * bucket increment. rdtsc takes about 20 cycles on bare metal, for some
+ * 15 ns per block in total, but may be trapped and several times slower
+ * in a virtual machine; simplegain-bench measures both.
+ *
+ * A single thread records. The counters are relaxed atomics, so other
+ * threads may read a summary at any time, which may be slightly stale.
+ *
+ * http://hdrhistogram.org
+ */
+
+#ifndef DSP_LOAD_METER_H
+#define DSP_LOAD_METER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+# include <x86intrin.h>
+# define DSP_LOAD_USE_TSC 1
+#endif
+
+class DspLoadMeter {
+public:
+    enum {
+        kSubBucketBits = 5,
+        kSubBuckets = 1 << kSubBucketBits,
+        kBucketCount = kSubBuckets + (32 - kSubBucketBits) * kSubBuckets,
+        kFixedPointBits = 3,  // ticks per frame are counted in eighths
+    };
+
+    struct Summary {
+        uint64_t blocks;
+        // fractions of the realtime budget
+        double mean, p50, p99, p999, max;
+    };
+
+    DspLoadMeter() { reset(); }
+
+    static inline uint64_t now() {
+#if defined(DSP_LOAD_USE_TSC)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void setSampleRate(double samplingRate) {
+        fs = samplingRate;
+    }
+
+    /**
+      Clear the histogram, and restart the measurement of the tick rate.
+    */
+    void reset() {
+        for (unsigned i = 0; i < kBucketCount; ++i)
+            counts[i].store(0, std::memory_order_relaxed);
+        blocks.store(0, std::memory_order_relaxed);
+        totalValue.store(0, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+        startTicks = now();
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    /**
+      Count a block of frames which started processing at the given ticks.
+    */
+    inline void record(uint64_t start, uint32_t frames) {
+        if (frames == 0)
+            return;
+
+        const float perFrame = (float)(now() - start) * (float)(1 << kFixedPointBits) / (float)frames;
+        const uint32_t value = (perFrame < 4294967040.0f) ? (uint32_t)perFrame : 0xffffff00u;
+
+        std::atomic<uint32_t>& count = counts[bucketIndex(value)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        blocks.store(blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totalValue.store(totalValue.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > maxValue.load(std::memory_order_relaxed))
+            maxValue.store(value, std::memory_order_relaxed);
+    }
+
+    static inline unsigned bucketIndex(uint32_t value) {
+        if (value < kSubBuckets)
+            return value;
+        const unsigned shift = (31 - __builtin_clz(value)) - kSubBucketBits;
+        return kSubBuckets + shift * kSubBuckets + ((value >> shift) - kSubBuckets);
+    }
+
+    // the middle of the range of values counted in a bucket
+    static inline double bucketValue(unsigned index) {
+        if (index < kSubBuckets)
+            return index;
+        const unsigned shift = (index - kSubBuckets) / kSubBuckets;
+        const unsigned sub = (index - kSubBuckets) % kSubBuckets;
+        return (double)((uint64_t)(kSubBuckets + sub) << shift) + 0.5 * (double)((1u << shift) - 1);
+    }
+
+    /**
+      Ticks per second: exact for the monotonic clock, measured for rdtsc.
+    */
+    double getTickRate() const {
+#if defined(DSP_LOAD_USE_TSC)
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return (seconds > 0.0) ? (double)(now() - startTicks) / seconds : 0.0;
+#else
+        return 1e9;
+#endif
+    }
+
+    /**
+      Load which a histogram value represents.
+    */
+    double valueToLoad(double value, double tickRate) const {
+        return (tickRate > 0.0) ? value * fs / ((double)(1 << kFixedPointBits) * tickRate) : 0.0;
+    }
+
+    Summary getSummary() const {
+        const double tickRate = getTickRate();
+        Summary summary;
+        summary.blocks = blocks.load(std::memory_order_relaxed);
+        summary.mean = summary.blocks ? valueToLoad((double)totalValue.load(std::memory_order_relaxed) / (double)summary.blocks, tickRate) : 0.0;
+        summary.max = valueToLoad(maxValue.load(std::memory_order_relaxed), tickRate);
+        summary.p50 = summary.p99 = summary.p999 = 0.0;
+
+        // ranks of the percentiles, one pass over the buckets
+        const uint64_t ranks[3] = {
+            (summary.blocks * 500 + 999) / 1000,
+            (summary.blocks * 990 + 999) / 1000,
+            (summary.blocks * 999 + 999) / 1000,
+        };
+        double* results[3] = {&summary.p50, &summary.p99, &summary.p999};
+        unsigned next = 0;
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < kBucketCount && next < 3; ++i) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            while (next < 3 && seen >= ranks[next] && ranks[next] > 0)
+                *results[next++] = valueToLoad(bucketValue(i), tickRate);
+        }
+        return summary;
+    }
+
+    /**
+      Write the summary and the non-empty buckets as a JSON object.
+    */
+    void writeJson(FILE* file) const {
+        const double tickRate = getTickRate();
+        const Summary summary = getSummary();
+        fprintf(file, "{\n  \"blocks\": %llu,\n  \"sample_rate\": %.1f,\n  \"tick_rate\": %.0f,\n",
+                (unsigned long long)summary.blocks, fs, tickRate);
+        fprintf(file, "  \"load\": {\"mean\": %.6f, \"p50\": %.6f, \"p99\": %.6f, \"p99.9\": %.6f, \"max\": %.6f},\n",
+                summary.mean, summary.p50, summary.p99, summary.p999, summary.max);
+        fprintf(file, "  \"histogram\": [");
+        const char* separator = "";
+        for (unsigned i = 0; i < kBucketCount; ++i) {
+            const uint32_t count = counts[i].load(std::memory_order_relaxed);
+            if (count == 0)
+                continue;
+            fprintf(file, "%s\n    {\"load\": %.6f, \"count\": %u}",
+                    separator, valueToLoad(bucketValue(i), tickRate), count);
+            separator = ",";
+        }
+        fprintf(file, "\n  ]\n}\n");
+    }
+
+private:
+    std::atomic<uint32_t> counts[kBucketCount];
+    std::atomic<uint64_t> blocks;
+    std::atomic<uint64_t> totalValue;
+    std::atomic<uint32_t> maxValue;
+
+    double fs = 44100.0;
+    uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+#endif  // #ifndef DSP_LOAD_METER_H
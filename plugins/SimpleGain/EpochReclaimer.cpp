@@ -0,0 +1,152 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "EpochReclaimer.hpp"
+#include <chrono>
+
+// -----------------------------------------------------------------------
+
+EpochReclaimer::~EpochReclaimer() {
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fQuit = true;
+    }
+    fCondition.notify_one();
+    if (fDeleter.joinable())
+        fDeleter.join();
+
+    for (const Retired& retired : fRetired)
+        retired.destroy(retired.object);
+}
+
+// -----------------------------------------------------------------------
+// Reading, on any thread
+//
+// All the accesses to the epochs and the published pointers are
+// sequentially consistent. A reader stamps its slot, then loads the
+// pointer; a writer exchanges the pointer, then advances the epoch. So a
+// reader which the reclaimer finds free or stamped at the new epoch loads
+// the pointer after the exchange, and cannot see the retired object.
+
+EpochReclaimer::ReadGuard::ReadGuard(EpochReclaimer& reclaimer) noexcept
+    : fReclaimer(reclaimer), fSlot(-1)
+{
+    // the address of a thread-local variable spreads the threads over the slots
+    static thread_local char marker;
+    const unsigned start = (unsigned)((uintptr_t)&marker >> 6);
+
+    const uint64_t epoch = reclaimer.fEpoch.load(std::memory_order_seq_cst);
+    for (unsigned i = 0; i < kMaxReaders; ++i) {
+        const unsigned slot = (start + i) % kMaxReaders;
+        uint64_t expected = 0;
+        if (reclaimer.fReaders[slot].epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst)) {
+            fSlot = (int)slot;
+            return;
+        }
+    }
+    reclaimer.fOverflow.fetch_add(1, std::memory_order_seq_cst);
+}
+
+EpochReclaimer::ReadGuard::~ReadGuard() noexcept {
+    if (fSlot >= 0)
+        fReclaimer.fReaders[fSlot].epoch.store(0, std::memory_order_release);
+    else
+        fReclaimer.fOverflow.fetch_sub(1, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------
+// Reclaiming
+
+void EpochReclaimer::retire(void* object, Destroy destroy) {
+    const uint64_t epoch = fEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fRetired.push_back({object, destroy, epoch});
+        if (!fDeleter.joinable())
+            fDeleter = std::thread(&EpochReclaimer::deleterMain, this);
+    }
+    fCondition.notify_one();
+}
+
+// the epoch of the oldest guard, or 0 when a guard has no slot
+uint64_t EpochReclaimer::getOldestEpoch() const noexcept {
+    if (fOverflow.load(std::memory_order_seq_cst) != 0)
+        return 0;
+
+    uint64_t oldest = UINT64_MAX;
+    for (const Reader& reader : fReaders) {
+        const uint64_t epoch = reader.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+    return oldest;
+}
+
+size_t EpochReclaimer::collect() {
+    std::vector<Retired> expired;
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        const uint64_t oldest = getOldestEpoch();
+        const auto keep = [oldest](const Retired& retired) { return retired.epoch > oldest; };
+
+        std::vector<Retired> kept;
+        for (const Retired& retired : fRetired)
+            (keep(retired) ? kept : expired).push_back(retired);
+        fRetired.swap(kept);
+        pending = fRetired.size();
+    }
+
+    for (const Retired& retired : expired)
+        retired.destroy(retired.object);
+    fDestroyed.fetch_add(expired.size(), std::memory_order_relaxed);
+    return pending;
+}
+
+size_t EpochReclaimer::getPendingCount() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fRetired.size();
+}
+
+/**
+  Asleep while nothing is retired; then, every few milliseconds, collect
+  what the readers have left, until nothing remains.
+*/
+void EpochReclaimer::deleterMain() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    const auto quit = [this] { return fQuit; };
+    for (;;) {
+        fCondition.wait(lock, [this] { return fQuit || !fRetired.empty(); });
+
+        // a little later than the retirement, for the readers to leave
+        if (fQuit || fCondition.wait_for(lock, std::chrono::milliseconds(10), quit))
+            break;
+        lock.unlock();
+        collect();
+        lock.lock();
+    }
+}
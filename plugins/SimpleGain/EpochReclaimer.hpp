@@ -0,0 +1,181 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef EPOCH_RECLAIMER_H
+#define EPOCH_RECLAIMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Epoch-based reclamation of objects shared with realtime threads.
+
+  A writer publishes a new version of an object by exchanging a pointer,
+  then retires the old version; readers follow the pointer only inside a
+  ReadGuard. A background thread destroys a retired object once every
+  guard which could have seen it is gone. Readers never wait, allocate or
+  free, and writers never wait for readers.
+
+  Each retirement advances a global epoch. A guard holds one of a fixed
+  set of reader slots, stamped with the epoch at which it was entered, and
+  an object retired at epoch E is destroyed when no slot holds an epoch
+  before E. Guards past kMaxReaders at once are counted apart, and hold
+  back all reclamation while they last. Guards may nest.
+
+  McKenney, Slingwine, "Read-copy update: using execution history to
+  solve concurrency problems", PDCS 1998
+  Fraser, "Practical lock-freedom", Cambridge TR-579, 2004
+*/
+class EpochReclaimer {
+public:
+    enum { kMaxReaders = 64 };
+
+    typedef void (*Destroy)(void* object);
+
+    EpochReclaimer() {}
+
+    // destroys the objects left; no guard may remain
+    ~EpochReclaimer();
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(EpochReclaimer& reclaimer) noexcept;
+        ~ReadGuard() noexcept;
+
+    private:
+        EpochReclaimer& fReclaimer;
+        int fSlot;  // or -1, counted apart
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+      Destroy an object once no reader can see it. It must already be out
+      of the reach of new readers. May lock and allocate, and starts the
+      background thread on the first call.
+    */
+    void retire(void* object, Destroy destroy);
+
+    template <class T>
+    void retire(T* object) {
+        retire(const_cast<void*>(static_cast<const void*>(object)),
+               [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    /**
+      Destroy now, on the calling thread, what can be; return the number of
+      objects still waiting.
+    */
+    size_t collect();
+
+    size_t getPendingCount();
+    uint64_t getDestroyedCount() const { return fDestroyed.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch {0};  // 0 when free
+    };
+
+    struct Retired {
+        void* object;
+        Destroy destroy;
+        uint64_t epoch;
+    };
+
+    uint64_t getOldestEpoch() const noexcept;
+    void deleterMain();
+
+    std::atomic<uint64_t> fEpoch {1};
+    std::atomic<uint32_t> fOverflow {0};
+    Reader fReaders[kMaxReaders];
+
+    std::mutex fMutex;
+    std::condition_variable fCondition;
+    std::vector<Retired> fRetired;
+    std::thread fDeleter;
+    bool fQuit = false;
+    std::atomic<uint64_t> fDestroyed {0};
+
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+};
+
+/**
+  A pointer which readers follow under a guard, and whose replaced values
+  are reclaimed. It owns its current value.
+*/
+template <class T>
+class EpochPointer {
+public:
+    explicit EpochPointer(EpochReclaimer& reclaimer, T* object = nullptr)
+        : fReclaimer(reclaimer), fPointer(object) {}
+
+    ~EpochPointer() { delete fPointer.load(std::memory_order_relaxed); }
+
+    // replace the value, the old one is retired
+    void publish(T* object) {
+        T* const old = fPointer.exchange(object, std::memory_order_seq_cst);
+        if (old)
+            fReclaimer.retire(old);
+    }
+
+    // the value, valid for as long as the reader lives
+    class Reader {
+    public:
+        explicit Reader(EpochPointer& pointer) noexcept
+            : fGuard(pointer.fReclaimer),
+              fObject(pointer.fPointer.load(std::memory_order_seq_cst)) {}
+
+        T* get() const noexcept { return fObject; }
+        T* operator->() const noexcept { return fObject; }
+        T& operator*() const noexcept { return *fObject; }
+
+    private:
+        EpochReclaimer::ReadGuard fGuard;
+        T* const fObject;
+    };
+
+    Reader read() noexcept { return Reader(*this); }
+
+private:
+    EpochReclaimer& fReclaimer;
+    std::atomic<T*> fPointer;
+
+    EpochPointer(const EpochPointer&) = delete;
+    EpochPointer& operator=(const EpochPointer&) = delete;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef EPOCH_RECLAIMER_H
@@ -0,0 +1,83 @@
+/**
+ * Equal-power crossfade gains
+ *
+ * Over a fade of N frames, the outgoing signal is weighted by cos(pi/2 t)
+ * and the incoming one by sin(pi/2 t), t going from 0 to 1, so that the
+ * sum of uncorrelated signals keeps its power. Both gains are the
+ * coordinates of a point turning by a fixed angle per frame, which costs
+ * four multiplications per frame instead of two calls to sin and cos;
+ * the rounding errors of the rotation stay far below audibility over the
+ * longest fade, and the gains are exactly 0 and 1 when it ends.
+ *
+ * A stage and its bypass are correlated signals, the same one processed or
+ * not, time-aligned; their sum peaks at cos + sin = sqrt(2), up to +3 dB at
+ * mid-fade where the stage changes the signal little. A linear fade would
+ * keep that sum, but dip uncorrelated signals by 3 dB.
+ */
+
+#ifndef EQUAL_POWER_FADE_H
+#define EQUAL_POWER_FADE_H
+
+#include <math.h>
+#include <stdint.h>
+
+class EqualPowerFade {
+public:
+    enum { kMaxLength = 1 << 16 };
+
+    EqualPowerFade() : remaining(0) { setLength(0); }
+
+    // zero disables the fade; a fade in progress keeps its length
+    void setLength(uint32_t frames) {
+        length = (frames < (uint32_t)kMaxLength) ? frames : (uint32_t)kMaxLength;
+        const double step = length ? 1.5707963267948966 / length : 0.0;
+        nextCos = (float)cos(step);
+        nextSin = (float)sin(step);
+    }
+
+    uint32_t getLength() const { return length; }
+
+    void start() {
+        remaining = length;
+        stepCos = nextCos;
+        stepSin = nextSin;
+        fadeOut = 1.0f;
+        fadeIn = 0.0f;
+    }
+
+    void stop() { remaining = 0; }
+
+    bool isActive() const { return remaining > 0; }
+
+    /**
+      Gains of the next frames, which are 0 and 1 after the end of the fade.
+    */
+    void next(float* out, float* in, uint32_t frames) {
+        uint32_t i = 0;
+        for (; i < frames && remaining > 1; ++i, --remaining) {
+            const float c = fadeOut * stepCos - fadeIn * stepSin;
+            fadeIn = fadeIn * stepCos + fadeOut * stepSin;
+            fadeOut = c;
+            out[i] = fadeOut;
+            in[i] = fadeIn;
+        }
+        if (remaining == 1) {
+            remaining = 0;
+            fadeOut = 0.0f;
+            fadeIn = 1.0f;
+        }
+        for (; i < frames; ++i) {
+            out[i] = 0.0f;
+            in[i] = 1.0f;
+        }
+    }
+
+private:
+    uint32_t remaining;
+    uint32_t length;
+    float fadeOut, fadeIn;
+    float stepCos, stepSin;
+    float nextCos, nextSin;  // of the next fade
+};
+
+#endif  // #ifndef EQUAL_POWER_FADE_H
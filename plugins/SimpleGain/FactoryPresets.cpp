@@ -0,0 +1,131 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "PluginSimpleGain.hpp"
+#include <cstdlib>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+struct FactoryPreset {
+    const char* name;
+    const char* category;
+    float params[PluginSimpleGain::paramMorph];  // the program parameters
+};
+
+// the presets when no bank is given
+static const FactoryPreset kFactoryPresets[] = {
+    {
+        "Unity Gain",
+        "Factory",
+        {0.0f, 0.0f, 0.0f, -1.0f}
+    }
+    //,{
+    //    "Another preset",  // preset name
+    //    "Category",        // preset category
+    //    {-14.0f, ...}      // array of the program parameter values
+    //}
+};
+
+// -----------------------------------------------------------------------
+
+// the symbols of the program parameters, which are the columns of a bank
+static std::vector<std::string> getPresetColumns() {
+    std::vector<std::string> columns;
+    for (uint32_t p = 0; p < PluginSimpleGain::paramCount; ++p) {
+        if (PluginSimpleGain::isProgramParameter(p))
+            columns.push_back(kParameterDescriptors[p].symbol);
+    }
+    return columns;
+}
+
+// the values are applied in the order of the parameters
+static bool matchesParameters(const PresetBank& bank) {
+    const std::vector<std::string> columns = getPresetColumns();
+    bool matches = bank.getColumnCount() == columns.size() && bank.getPresetCount() > 0;
+    for (uint32_t c = 0; matches && c < columns.size(); ++c)
+        matches = columns[c] == bank.getColumnSymbol(c);
+    return matches;
+}
+
+static PresetBank* openBankFile(const char* path) {
+    PresetBank* bank = new PresetBank;
+    if (!bank->open(path)) {
+        d_stderr2("SimpleGain: cannot load the presets of %s: %s", path, bank->getError().c_str());
+    } else if (!matchesParameters(*bank)) {
+        d_stderr2("SimpleGain: the presets of %s do not match the parameters", path);
+    } else {
+        return bank;
+    }
+    delete bank;
+    return nullptr;
+}
+
+static PresetBank* openInitialBank() {
+    const char* path = std::getenv("SIMPLEGAIN_PRESETS");
+    if (path && path[0]) {
+        if (PresetBank* bank = openBankFile(path))
+            return bank;
+    }
+
+    PresetBankBuilder builder(getPresetColumns());
+    for (const FactoryPreset& preset : kFactoryPresets)
+        builder.add(preset.name, preset.category, preset.params);
+    PresetBank* bank = new PresetBank;
+    bank->open(builder.build());
+    return bank;
+}
+
+// The bank of the whole process, opened by the first instance; the banks
+// it replaces are destroyed once no reader is left, see EpochReclaimer.hpp
+struct SharedPresetBank {
+    EpochReclaimer reclaimer;
+    EpochPointer<const PresetBank> bank {reclaimer, openInitialBank()};
+};
+
+static SharedPresetBank& getSharedPresetBank() {
+    static SharedPresetBank shared;
+    return shared;
+}
+
+PluginSimpleGain::PresetBankReader PluginSimpleGain::getPresetBank() {
+    return getSharedPresetBank().bank.read();
+}
+
+bool PluginSimpleGain::setPresetBank(PresetBank* bank) {
+    if (!matchesParameters(*bank)) {
+        delete bank;
+        return false;
+    }
+    getSharedPresetBank().bank.publish(bank);
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,243 @@
+/**
+ * Batch of smoothed gain stages, in structure-of-arrays layout
+ *
+ * A slot is a stereo gain stage whose gain follows its target through the
+ * one-pole smoother of CParamSmooth. The smoother coefficients, states and
+ * target gains of all the slots are kept in contiguous arrays, so that many
+ * slots are processed together: the gains of four slots are advanced in one
+ * SSE vector per frame, a tile of frames at a time, then transposed and
+ * applied to the buffers of each slot.
+ *
+ * A slot does the arithmetic of CParamSmooth::process, whether it is
+ * processed alone or in a batch, and gives the same results to the bit.
+ *
+ * All the arrays are in one block, allocated by the constructor, or inline
+ * in a FixedGainBatch; the list of free slots is an array of its own. Slots are acquired and released from one thread at
+ * a time, a slot is processed by one thread at a time, and processing does
+ * not allocate.
+ */
+
+#ifndef GAIN_BATCH_H
+#define GAIN_BATCH_H
+
+#include "CParamSmooth.hpp"
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define GAIN_BATCH_USE_SSE 1
+#endif
+
+class GainBatch {
+public:
+    enum {
+        kChannels = 2,
+        kLanes = 4,
+        kTile = 64,  // frames of gains computed before they are applied
+    };
+
+    // the arrays, one word per slot each, one after the other
+    enum Array {
+        kCoefA,
+        kCoefB,
+        kTarget,
+        kState,
+        kRate,
+        kWordsPerSlot
+    };
+
+    explicit GainBatch(uint32_t capacity, float smoothingTimeMs = 20.0f) {
+        init(new float[kWordsPerSlot * capacity](), new uint32_t[capacity], capacity, smoothingTimeMs);
+        fOwned = true;
+    }
+
+    ~GainBatch() {
+        if (fOwned) {
+            delete[] fStorage;
+            delete[] fFreeList;
+        }
+    }
+
+    GainBatch(const GainBatch&) = delete;
+    GainBatch& operator=(const GainBatch&) = delete;
+
+    uint32_t getCapacity() const { return fCapacity; }
+
+    /**
+      Take a free slot, which starts silent, or return -1 if there is none.
+    */
+    int acquire() {
+        if (fFreeCount == 0)
+            return -1;
+        const uint32_t slot = fFreeList[--fFreeCount];
+        for (unsigned array = kCoefA; array < kWordsPerSlot; ++array)
+            getArray((Array)array)[slot] = 0.0f;
+        return (int)slot;
+    }
+
+    void release(uint32_t slot) {
+        fFreeList[fFreeCount++] = slot;
+    }
+
+    /**
+      Compute the smoother coefficients; when the rate changes, this also
+      resets the smoothed gain, as CParamSmooth::setSampleRate does.
+    */
+    void setSampleRate(uint32_t slot, float samplingRate) {
+        if (samplingRate != getArray(kRate)[slot]) {
+            const float a = CParamSmooth::pole(fSmoothingTime, samplingRate);
+            getArray(kRate)[slot] = samplingRate;
+            getArray(kCoefA)[slot] = a;
+            getArray(kCoefB)[slot] = 1.0f - a;
+            getArray(kState)[slot] = 0.0f;
+        }
+    }
+
+    float getTarget(uint32_t slot) const { return getArray(kTarget)[slot]; }
+    void setTarget(uint32_t slot, float gain) { getArray(kTarget)[slot] = gain; }
+
+    // the smoothed gain after the last frame processed
+    float getState(uint32_t slot) const { return getArray(kState)[slot]; }
+    void setState(uint32_t slot, float value) { getArray(kState)[slot] = value; }
+    void reset(uint32_t slot) { getArray(kState)[slot] = 0.0f; }
+
+    /**
+      Advance the smoother of a slot by one frame, without audio.
+    */
+    inline float step(uint32_t slot) {
+        float& z = getArray(kState)[slot];
+        return z = (getArray(kTarget)[slot] * getArray(kCoefB)[slot]) + (z * getArray(kCoefA)[slot]);
+    }
+
+    /**
+      Process the stereo buffers of one slot. May be done in place.
+    */
+    void processSlot(uint32_t slot, const float* const* inputs, float* const* outputs, uint32_t frames) {
+        const float a = getArray(kCoefA)[slot];
+        const float b = getArray(kCoefB)[slot];
+        const float target = getArray(kTarget)[slot];
+        float z = getArray(kState)[slot];
+
+        const float* const inL = inputs[0];
+        const float* const inR = inputs[1];
+        float* const outL = outputs[0];
+        float* const outR = outputs[1];
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            z = (target * b) + (z * a);
+            outL[i] = inL[i] * z;
+            outR[i] = inR[i] * z;
+        }
+        getArray(kState)[slot] = z;
+    }
+
+    /**
+      Process the slots from first to first + count - 1. The buffers of
+      slot first + k are inputs[kChannels * k + c] and outputs[kChannels * k + c].
+      May be done in place.
+    */
+    void process(uint32_t first, uint32_t count, const float* const* inputs, float* const* outputs, uint32_t frames) {
+        uint32_t k = 0;
+#if defined(GAIN_BATCH_USE_SSE)
+        for (; k + kLanes <= count; k += kLanes)
+            processLanes(first + k, inputs + kChannels * k, outputs + kChannels * k, frames);
+#endif
+        for (; k < count; ++k)
+            processSlot(first + k, inputs + kChannels * k, outputs + kChannels * k, frames);
+    }
+
+protected:
+    // on storage of kWordsPerSlot * capacity words and a free list of
+    // capacity slots, which the caller keeps
+    GainBatch(float* storage, uint32_t* freeList, uint32_t capacity, float smoothingTimeMs) {
+        init(storage, freeList, capacity, smoothingTimeMs);
+    }
+
+private:
+    void init(float* storage, uint32_t* freeList, uint32_t capacity, float smoothingTimeMs) {
+        fStorage = storage;
+        fFreeList = freeList;
+        fCapacity = fFreeCount = capacity;
+        fSmoothingTime = smoothingTimeMs;
+        fOwned = false;
+
+        // the lowest slots first, so that a full batch is contiguous
+        for (uint32_t i = 0; i < capacity; ++i)
+            freeList[i] = capacity - 1 - i;
+    }
+
+    float* getArray(Array array) const { return fStorage + array * fCapacity; }
+
+#if defined(GAIN_BATCH_USE_SSE)
+    void processLanes(uint32_t slot, const float* const* inputs, float* const* outputs, uint32_t frames) {
+        float* const state = getArray(kState) + slot;
+        const __m128 a = _mm_loadu_ps(getArray(kCoefA) + slot);
+        const __m128 targetB = _mm_mul_ps(_mm_loadu_ps(getArray(kTarget) + slot), _mm_loadu_ps(getArray(kCoefB) + slot));
+        __m128 z = _mm_loadu_ps(state);
+
+        // one row of gains per slot
+        alignas(16) float gains[kLanes][kTile];
+
+        for (uint32_t offset = 0; offset < frames; offset += kTile) {
+            const uint32_t count = (frames - offset < (uint32_t)kTile) ? (frames - offset) : (uint32_t)kTile;
+
+            uint32_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                // four frames of four slots, transposed into four frames per slot
+                __m128 g0 = z = _mm_add_ps(targetB, _mm_mul_ps(z, a));
+                __m128 g1 = z = _mm_add_ps(targetB, _mm_mul_ps(z, a));
+                __m128 g2 = z = _mm_add_ps(targetB, _mm_mul_ps(z, a));
+                __m128 g3 = z = _mm_add_ps(targetB, _mm_mul_ps(z, a));
+                _MM_TRANSPOSE4_PS(g0, g1, g2, g3);
+                _mm_store_ps(&gains[0][i], g0);
+                _mm_store_ps(&gains[1][i], g1);
+                _mm_store_ps(&gains[2][i], g2);
+                _mm_store_ps(&gains[3][i], g3);
+            }
+            for (; i < count; ++i) {
+                alignas(16) float g[kLanes];
+                z = _mm_add_ps(targetB, _mm_mul_ps(z, a));
+                _mm_store_ps(g, z);
+                for (unsigned lane = 0; lane < kLanes; ++lane)
+                    gains[lane][i] = g[lane];
+            }
+
+            for (unsigned lane = 0; lane < kLanes; ++lane) {
+                const float* const gain = gains[lane];
+                for (unsigned c = 0; c < kChannels; ++c) {
+                    const float* const in = inputs[kChannels * lane + c] + offset;
+                    float* const out = outputs[kChannels * lane + c] + offset;
+                    for (uint32_t j = 0; j < count; ++j)
+                        out[j] = in[j] * gain[j];
+                }
+            }
+        }
+
+        _mm_storeu_ps(state, z);
+    }
+#endif
+
+    // small, to fit in a cache line with the storage of a few slots
+    float* fStorage;
+    uint32_t* fFreeList;  // control side, not processed
+    uint32_t fCapacity;
+    uint32_t fFreeCount;
+    float fSmoothingTime;
+    bool fOwned;
+};
+
+/**
+  A batch with its storage inline, which allocates nothing.
+*/
+template <uint32_t Capacity>
+class FixedGainBatch : public GainBatch {
+public:
+    explicit FixedGainBatch(float smoothingTimeMs = 20.0f)
+        : GainBatch(fInline, fInlineFreeList, Capacity, smoothingTimeMs) {}
+
+private:
+    float fInline[kWordsPerSlot * Capacity];
+    uint32_t fInlineFreeList[Capacity];
+};
+
+#endif  // #ifndef GAIN_BATCH_H
@@ -0,0 +1,131 @@
+/**
+ * Coalescing of the parameter changes of UI gestures
+ *
+ * While a widget is dragged, its value may change on every frame, and
+ * every change sent goes through the parameter pipeline of the host and,
+ * when it records, becomes an automation point. During a gesture, this
+ * sends at most one value per interval, the latest one. Of the values
+ * which continue the line of the last two sent, within a tolerance, it
+ * sends one per hold time only: the host draws that line between the
+ * points it records, so the others would be redundant, and the hold
+ * bounds how long the DSP lags behind. The end of a gesture always sends
+ * the final value, and a change outside a gesture is sent at once.
+ *
+ * Times are in seconds, from any origin.
+ */
+
+#ifndef GESTURE_COALESCER_H
+#define GESTURE_COALESCER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+class GestureCoalescer {
+public:
+    struct Settings {
+        double interval = 1.0 / 30.0;  // at least between two values sent
+        double maxHold = 0.1;          // at most, while values are on a line
+        float tolerance = 0.0025f;     // distance to the line, in parts of the range
+    };
+
+    explicit GestureCoalescer(uint32_t count) : fStates(count) {}
+
+    const Settings& getSettings() const { return fSettings; }
+    void setSettings(const Settings& settings) { fSettings = settings; }
+
+    // the range of a parameter, for the tolerance
+    void setRange(uint32_t index, float min, float max) { fStates[index].range = max - min; }
+
+    bool isActive(uint32_t index) const { return fStates[index].active; }
+
+    void begin(uint32_t index, double time) {
+        State& state = fStates[index];
+        state.active = true;
+        state.pending = false;
+        state.sentCount = 0;
+        state.sentTime[1] = time;
+    }
+
+    /**
+      A new value; true if it is to be sent now, as it is outside a gesture.
+    */
+    bool change(uint32_t index, float value, double time) {
+        State& state = fStates[index];
+        if (!state.active)
+            return true;
+        state.value = value;
+        state.changeTime = time;
+        state.pending = state.sentCount == 0 || value != state.sentValue[1];
+        return false;
+    }
+
+    /**
+      Send the values which are due at this time, with send(index, value).
+    */
+    template <class Send>
+    void flush(double time, Send&& send) {
+        for (uint32_t index = 0; index < (uint32_t)fStates.size(); ++index) {
+            State& state = fStates[index];
+            if (state.active && state.pending && isDue(state, time)) {
+                send(index, state.value);
+                record(state, time);
+            }
+        }
+    }
+
+    /**
+      End a gesture; true with the final value if it was not sent.
+    */
+    bool end(uint32_t index, float& value) {
+        State& state = fStates[index];
+        const bool pending = state.active && state.pending;
+        state.active = false;
+        state.pending = false;
+        value = state.value;
+        return pending;
+    }
+
+private:
+    struct State {
+        bool active = false;
+        bool pending = false;
+        float value = 0.0f;
+        double changeTime = 0.0;
+        float range = 1.0f;
+        uint32_t sentCount = 0;
+        float sentValue[2] = {};   // the last one at 1
+        double sentTime[2] = {};
+    };
+
+    bool isDue(const State& state, double time) const {
+        // the first value of a gesture goes at once
+        if (state.sentCount == 0)
+            return true;
+        const double elapsed = time - state.sentTime[1];
+        if (elapsed < fSettings.interval)
+            return false;
+        const double span = state.sentTime[1] - state.sentTime[0];
+        if (state.sentCount < 2 || elapsed >= fSettings.maxHold || span <= 0.0)
+            return true;
+
+        // off the line of the last two values sent
+        const double slope = (state.sentValue[1] - state.sentValue[0]) / span;
+        const double predicted = state.sentValue[1] + slope * (state.changeTime - state.sentTime[1]);
+        return fabs(state.value - predicted) > fSettings.tolerance * state.range;
+    }
+
+    void record(State& state, double time) {
+        state.sentValue[0] = state.sentValue[1];
+        state.sentTime[0] = state.sentTime[1];
+        state.sentValue[1] = state.value;
+        state.sentTime[1] = time;
+        ++state.sentCount;
+        state.pending = false;
+    }
+
+    std::vector<State> fStates;
+    Settings fSettings;
+};
+
+#endif  // #ifndef GESTURE_COALESCER_H
@@ -0,0 +1,217 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "HostTrace.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+# include <process.h>
+# define getpid _getpid
+#else
+# include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+
+static std::atomic<unsigned> gInstanceCount {0};
+
+HostTraceRecorder* HostTraceRecorder::createFromEnvironment(double sampleRate, uint32_t bufferSize) {
+    const char* prefix = std::getenv("SIMPLEGAIN_TRACE");
+    if (!prefix || !prefix[0])
+        return nullptr;
+
+    const std::string path = std::string(prefix) + "-" + std::to_string((long)getpid()) + "-" +
+        std::to_string(gInstanceCount.fetch_add(1)) + ".sgtrace";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return nullptr;
+
+    HostTraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "SGTRACE", 8);
+    header.version = kHostTraceVersion;
+    header.eventSize = sizeof(HostTraceEvent);
+    header.sampleRate = sampleRate;
+    header.bufferSize = bufferSize;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        return nullptr;
+    }
+
+    return new HostTraceRecorder(file);
+}
+
+HostTraceRecorder::HostTraceRecorder(FILE* file)
+    : fFile(file),
+      fBuffers(new ThreadBuffer[kMaxThreads])
+{
+    fWriter = std::thread(&HostTraceRecorder::writerMain, this);
+}
+
+HostTraceRecorder::~HostTraceRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fQuit = true;
+    }
+    fCondition.notify_one();
+    fWriter.join();
+
+    drain();
+    std::fclose(fFile);
+}
+
+// -----------------------------------------------------------------------
+// Recording, on the calling threads
+
+void HostTraceRecorder::recordParameter(uint32_t index, float value) noexcept {
+    HostTraceEvent event;
+    event.type = kTraceSetParameter;
+    event.param.index = index;
+    event.param.value = value;
+    record(event);
+}
+
+void HostTraceRecorder::recordProgram(uint32_t index) noexcept {
+    HostTraceEvent event;
+    event.type = kTraceLoadProgram;
+    event.param.index = index;
+    event.param.value = 0.0f;
+    record(event);
+}
+
+void HostTraceRecorder::recordSampleRate(double sampleRate) noexcept {
+    HostTraceEvent event;
+    event.type = kTraceSampleRate;
+    event.sampleRate = sampleRate;
+    record(event);
+}
+
+void HostTraceRecorder::recordActivate() noexcept {
+    HostTraceEvent event;
+    event.type = kTraceActivate;
+    event.sampleRate = 0.0;
+    record(event);
+}
+
+void HostTraceRecorder::recordRun(uint32_t frames) noexcept {
+    HostTraceEvent event;
+    event.type = kTraceRun;
+    event.sampleRate = 0.0;
+    event.frames = frames;
+    record(event);
+}
+
+/**
+  The buffer owned by the calling thread, claimed on its first call.
+*/
+HostTraceRecorder::ThreadBuffer* HostTraceRecorder::findBuffer(uint8_t& index) noexcept {
+    // the address of a thread-local variable identifies the thread
+    static thread_local char marker;
+    const uintptr_t self = (uintptr_t)&marker;
+
+    for (unsigned i = 0; i < kMaxThreads; ++i) {
+        const uintptr_t owner = fBuffers[i].owner.load(std::memory_order_relaxed);
+        if (owner == self) {
+            index = (uint8_t)i;
+            return &fBuffers[i];
+        }
+        if (owner == 0) {
+            uintptr_t expected = 0;
+            if (fBuffers[i].owner.compare_exchange_strong(expected, self, std::memory_order_relaxed) ||
+                expected == self) {
+                index = (uint8_t)i;
+                return &fBuffers[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+void HostTraceRecorder::record(HostTraceEvent& event) noexcept {
+    event.sequence = fSequence.fetch_add(1, std::memory_order_relaxed);
+    event.reserved = 0;
+
+    ThreadBuffer* buffer = findBuffer(event.thread);
+    if (!buffer) {
+        fUnbuffered.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint32_t head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) >= kBufferEvents) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[head & (kBufferEvents - 1)] = event;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------
+// Writing, on the background thread
+
+void HostTraceRecorder::writerMain() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    while (!fQuit) {
+        fCondition.wait_for(lock, std::chrono::milliseconds(50));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void HostTraceRecorder::drain() {
+    uint32_t dropped = fUnbuffered.exchange(0, std::memory_order_relaxed);
+
+    for (unsigned i = 0; i < kMaxThreads; ++i) {
+        ThreadBuffer& buffer = fBuffers[i];
+        const uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+        const uint32_t head = buffer.head.load(std::memory_order_acquire);
+
+        // the pending events, in at most two pieces around the end of the ring
+        const uint32_t start = tail & (kBufferEvents - 1);
+        const uint32_t count = head - tail;
+        const uint32_t first = (count < kBufferEvents - start) ? count : (kBufferEvents - start);
+        std::fwrite(buffer.events + start, sizeof(HostTraceEvent), first, fFile);
+        std::fwrite(buffer.events, sizeof(HostTraceEvent), count - first, fFile);
+        buffer.tail.store(head, std::memory_order_release);
+
+        dropped += buffer.dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (dropped > 0) {
+        HostTraceEvent event;
+        std::memset(&event, 0, sizeof(event));
+        event.sequence = fSequence.load(std::memory_order_relaxed);
+        event.type = kTraceDropped;
+        event.param.index = dropped;
+        std::fwrite(&event, sizeof(event), 1, fFile);
+    }
+
+    std::fflush(fFile);
+}
@@ -0,0 +1,148 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HOST_TRACE_H
+#define HOST_TRACE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// -----------------------------------------------------------------------
+
+/**
+  Trace of the calls made by the host, to reproduce performance problems.
+
+  Recording is opt-in: when the environment variable SIMPLEGAIN_TRACE is
+  set to a path prefix, each instance writes the calls it receives to
+  <prefix>-<pid>-<instance>.sgtrace, which simplegain-replay runs against
+  a fresh instance.
+
+  The file is a HostTraceHeader followed by HostTraceEvent records, in the
+  byte order of the machine. Records of different threads are interleaved
+  in no particular order; the sequence numbers give the order of the calls.
+*/
+
+enum HostTraceEventType {
+    kTraceSetParameter = 1,  // param.index, param.value
+    kTraceLoadProgram,       // param.index
+    kTraceSampleRate,        // sampleRate
+    kTraceActivate,
+    kTraceRun,               // frames
+    kTraceDropped,           // param.index events lost to full buffers
+};
+
+struct HostTraceHeader {
+    char magic[8];           // "SGTRACE"
+    uint32_t version;
+    uint32_t eventSize;
+    double sampleRate;       // at instantiation
+    uint32_t bufferSize;
+    uint32_t reserved;
+};
+
+struct HostTraceEvent {
+    uint32_t sequence;
+    uint8_t type;
+    uint8_t thread;          // buffer of the calling thread
+    uint16_t reserved;
+    union {
+        struct {
+            uint32_t index;
+            float value;
+        } param;
+        uint32_t frames;
+        double sampleRate;
+    };
+};
+
+static const uint32_t kHostTraceVersion = 1;
+
+/**
+  Records the calls of one instance.
+
+  Each calling thread claims one of a fixed set of single-producer ring
+  buffers on its first call, so recording never locks nor allocates. A
+  background thread drains the buffers to the file. When a buffer is full,
+  the event is counted as dropped.
+*/
+class HostTraceRecorder {
+public:
+    enum {
+        kMaxThreads = 8,
+        kBufferEvents = 16384,  // a power of two
+    };
+
+    /**
+      Create a recorder if SIMPLEGAIN_TRACE is set, otherwise return null.
+    */
+    static HostTraceRecorder* createFromEnvironment(double sampleRate, uint32_t bufferSize);
+
+    ~HostTraceRecorder();
+
+    void recordParameter(uint32_t index, float value) noexcept;
+    void recordProgram(uint32_t index) noexcept;
+    void recordSampleRate(double sampleRate) noexcept;
+    void recordActivate() noexcept;
+    void recordRun(uint32_t frames) noexcept;
+
+private:
+    struct ThreadBuffer {
+        std::atomic<uintptr_t> owner {0};
+        std::atomic<uint32_t> dropped {0};
+        alignas(64) std::atomic<uint32_t> head {0};  // written by the owner
+        alignas(64) std::atomic<uint32_t> tail {0};  // written by the writer
+        HostTraceEvent events[kBufferEvents];
+    };
+
+    explicit HostTraceRecorder(FILE* file);
+
+    void record(HostTraceEvent& event) noexcept;
+    ThreadBuffer* findBuffer(uint8_t& index) noexcept;
+    void writerMain();
+    void drain();
+
+    FILE* fFile;
+    std::unique_ptr<ThreadBuffer[]> fBuffers;
+    std::atomic<uint32_t> fSequence {0};
+    std::atomic<uint32_t> fUnbuffered {0};  // calls from too many threads
+
+    std::thread fWriter;
+    std::mutex fMutex;
+    std::condition_variable fCondition;
+    bool fQuit = false;
+
+    HostTraceRecorder(const HostTraceRecorder&) = delete;
+    HostTraceRecorder& operator=(const HostTraceRecorder&) = delete;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef HOST_TRACE_H
@@ -23,6 +23,16 @@
 #include "Window.hpp"
 #include <chrono>
 #include <cmath>
+#include <string>
+
+// last, for the macros of X11
+#if defined(_WIN32)
+# include <windows.h>
+#elif defined(__APPLE__)
+# include <OpenGL/OpenGL.h>
+#else
+# include <GL/glx.h>
+#endif
 
 START_NAMESPACE_DGL
 
@@ -32,7 +42,10 @@ struct ImGuiUI::Impl
     ~Impl();
 
     void setupGL();
-    void cleanupGL();
+    void releaseContext();
+    void shutdownBackend();
+    void shutdownReleasedBackend();
+    void idleHidden();
 
     // perhaps DPF will implement this in the future
     float getScaleFactor() const { return 1.0f; }
@@ -43,10 +56,59 @@ struct ImGuiUI::Impl
     ImGuiContext* fContext = nullptr;
     Color fBackgroundColor{0.25f, 0.25f, 0.25f};
     int fRepaintIntervalMs = 15;
+    int fReleaseDelayMs = 5000;
 
     using Clock = std::chrono::steady_clock;
     Clock::time_point fLastRepainted;
     bool fWasEverPainted = false;
+
+    // while the window is hidden with a context
+    bool fHidden = false;
+    Clock::time_point fHiddenSince;
+
+    // the ImGui settings, kept while there is no context
+    std::string fSettings;
+
+    // the backend of a released context, whose GL objects are deleted
+    // with the GL context of the window made current; from 1.84, ImGui
+    // keeps its data in the context
+    bool fBackendReleased = false;
+#if IMGUI_VERSION_NUM >= 18400
+    void* fBackendData = nullptr;
+    const char* fBackendName = nullptr;
+#endif
+
+    /**
+      The GL context of the window, as it was current at the last display.
+      The Window of this DPF enters its context for the display only, and
+      has no call to enter it from idle, so it is entered here through the
+      platform API, and the context which was current is restored after.
+    */
+    struct GLContext
+    {
+        void capture();
+        bool enter();
+        void leave();
+
+#if defined(_WIN32)
+        HDC fDevice = nullptr;
+        HGLRC fContext = nullptr;
+        HDC fPreviousDevice = nullptr;
+        HGLRC fPrevious = nullptr;
+#elif defined(__APPLE__)
+        CGLContextObj fContext = nullptr;
+        CGLContextObj fPrevious = nullptr;
+#else
+        Display* fDisplay = nullptr;
+        GLXDrawable fDrawable = 0;
+        GLXContext fContext = nullptr;
+        Display* fPreviousDisplay = nullptr;
+        GLXDrawable fPreviousDraw = 0;
+        GLXDrawable fPreviousRead = 0;
+        GLXContext fPrevious = nullptr;
+#endif
+    };
+    GLContext fGLContext;
 };
 
 ImGuiUI::ImGuiUI(int width, int height)
@@ -72,8 +134,19 @@ void ImGuiUI::setRepaintInterval(int intervalMs)
     fImpl->fRepaintIntervalMs = intervalMs;
 }
 
+void ImGuiUI::setReleaseDelay(int delayMs)
+{
+    fImpl->fReleaseDelayMs = delayMs;
+}
+
 void ImGuiUI::onDisplay()
 {
+    // the GL context is current here
+    fImpl->fGLContext.capture();
+    if (!fImpl->fContext)
+        fImpl->setupGL();
+    fImpl->fHidden = false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
 
 #if defined(IMGUI_GL2)
@@ -107,6 +180,9 @@ void ImGuiUI::onDisplay()
 
 bool ImGuiUI::onKeyboard(const KeyboardEvent& event)
 {
+    if (!fImpl->fContext)
+        return false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -126,6 +202,9 @@ bool ImGuiUI::onKeyboard(const KeyboardEvent& event)
 
 bool ImGuiUI::onSpecial(const SpecialEvent& event)
 {
+    if (!fImpl->fContext)
+        return false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -155,6 +234,9 @@ bool ImGuiUI::onSpecial(const SpecialEvent& event)
 
 bool ImGuiUI::onMouse(const MouseEvent& event)
 {
+    if (!fImpl->fContext)
+        return false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -167,6 +249,9 @@ bool ImGuiUI::onMouse(const MouseEvent& event)
 
 bool ImGuiUI::onMotion(const MotionEvent& event)
 {
+    if (!fImpl->fContext)
+        return false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -179,6 +264,9 @@ bool ImGuiUI::onMotion(const MotionEvent& event)
 
 bool ImGuiUI::onScroll(const ScrollEvent& event)
 {
+    if (!fImpl->fContext)
+        return false;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -192,6 +280,10 @@ void ImGuiUI::uiReshape(uint width, uint height)
 {
     UI::uiReshape(width, height);
 
+    // a context to come takes the size of the window
+    if (!fImpl->fContext)
+        return;
+
     ImGui::SetCurrentContext(fImpl->fContext);
     ImGuiIO &io = ImGui::GetIO();
 
@@ -202,6 +294,12 @@ void ImGuiUI::uiReshape(uint width, uint height)
 
 void ImGuiUI::idleCallback()
 {
+    if (!getParentWindow().isVisible())
+    {
+        fImpl->idleHidden();
+        return;
+    }
+
     bool shouldRepaint;
 
     if (fImpl->fWasEverPainted)
@@ -224,12 +322,13 @@ void ImGuiUI::idleCallback()
 ImGuiUI::Impl::Impl(ImGuiUI* self)
     : fSelf(self)
 {
-    setupGL();
 }
 
 ImGuiUI::Impl::~Impl()
 {
-    cleanupGL();
+    if (fContext)
+        releaseContext();
+    shutdownReleasedBackend();
 }
 
 void ImGuiUI::Impl::setupGL()
@@ -271,6 +370,12 @@ void ImGuiUI::Impl::setupGL()
     io.KeyMap[ImGuiKey_Y] = 'Y';
     io.KeyMap[ImGuiKey_Z] = 'Z';
 
+    if (!fSettings.empty())
+        ImGui::LoadIniSettingsFromMemory(fSettings.data(), fSettings.size());
+
+    // the GL objects of the last context, before new ones are made
+    shutdownBackend();
+
 #if defined(IMGUI_GL2)
     ImGui_ImplOpenGL2_Init();
 #elif defined(IMGUI_GL3)
@@ -278,17 +383,168 @@ void ImGuiUI::Impl::setupGL()
 #endif
 }
 
-void ImGuiUI::Impl::cleanupGL()
+/**
+  Destroy the context, which needs no GL context, keeping its settings.
+  The backend is detached from it, to be shut down by shutdownBackend().
+*/
+void ImGuiUI::Impl::releaseContext()
 {
     ImGui::SetCurrentContext(fContext);
+    fSettings = ImGui::SaveIniSettingsToMemory();
+
+#if IMGUI_VERSION_NUM >= 18400
+    ImGuiIO &io = ImGui::GetIO();
+    fBackendData = io.BackendRendererUserData;
+    fBackendName = io.BackendRendererName;
+    io.BackendRendererUserData = nullptr;
+    io.BackendRendererName = nullptr;
+#endif
+    fBackendReleased = true;
+
+    ImGui::DestroyContext(fContext);
+    fContext = nullptr;
+}
+
+/**
+  Delete the GL objects of a released backend, with the GL context current
+  and any ImGui context, to which it is attached to be shut down.
+*/
+void ImGuiUI::Impl::shutdownBackend()
+{
+    if (!fBackendReleased)
+        return;
+
+#if IMGUI_VERSION_NUM >= 18400
+    ImGuiIO &io = ImGui::GetIO();
+    io.BackendRendererUserData = fBackendData;
+    io.BackendRendererName = fBackendName;
+    fBackendData = nullptr;
+    fBackendName = nullptr;
+#endif
+
 #if defined(IMGUI_GL2)
     ImGui_ImplOpenGL2_Shutdown();
 #elif defined(IMGUI_GL3)
     ImGui_ImplOpenGL3_Shutdown();
 #endif
-    ImGui::DestroyContext(fContext);
+    fBackendReleased = false;
 }
 
+/**
+  Shut down a released backend, in an ImGui context of its own, the one it
+  was attached to being gone, and in the GL context of the window.
+*/
+void ImGuiUI::Impl::shutdownReleasedBackend()
+{
+    if (!fBackendReleased || !fGLContext.enter())
+        return;
+
+    ImGuiContext* context = ImGui::CreateContext();
+    ImGui::SetCurrentContext(context);
+    shutdownBackend();
+    ImGui::DestroyContext(context);
+    fGLContext.leave();
+}
+
+void ImGuiUI::Impl::idleHidden()
+{
+    if (!fContext)
+        return;
+
+    const Clock::time_point now = Clock::now();
+    if (!fHidden)
+    {
+        fHidden = true;
+        fHiddenSince = now;
+        return;
+    }
+
+    std::chrono::milliseconds hiddenMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - fHiddenSince);
+    if (fReleaseDelayMs >= 0 && hiddenMs.count() >= fReleaseDelayMs)
+    {
+        fSelf->onImGuiRelease();
+        releaseContext();
+        shutdownReleasedBackend();
+    }
+}
+
+#if defined(_WIN32)
+
+void ImGuiUI::Impl::GLContext::capture()
+{
+    fDevice = wglGetCurrentDC();
+    fContext = wglGetCurrentContext();
+}
+
+bool ImGuiUI::Impl::GLContext::enter()
+{
+    if (!fContext)
+        return false;
+    fPreviousDevice = wglGetCurrentDC();
+    fPrevious = wglGetCurrentContext();
+    return fPrevious == fContext || wglMakeCurrent(fDevice, fContext);
+}
+
+void ImGuiUI::Impl::GLContext::leave()
+{
+    if (fPrevious != fContext)
+        wglMakeCurrent(fPreviousDevice, fPrevious);
+}
+
+#elif defined(__APPLE__)
+
+void ImGuiUI::Impl::GLContext::capture()
+{
+    fContext = CGLGetCurrentContext();
+}
+
+bool ImGuiUI::Impl::GLContext::enter()
+{
+    if (!fContext)
+        return false;
+    fPrevious = CGLGetCurrentContext();
+    return fPrevious == fContext || CGLSetCurrentContext(fContext) == kCGLNoError;
+}
+
+void ImGuiUI::Impl::GLContext::leave()
+{
+    if (fPrevious != fContext)
+        CGLSetCurrentContext(fPrevious);
+}
+
+#else
+
+void ImGuiUI::Impl::GLContext::capture()
+{
+    fDisplay = glXGetCurrentDisplay();
+    fDrawable = glXGetCurrentDrawable();
+    fContext = glXGetCurrentContext();
+}
+
+bool ImGuiUI::Impl::GLContext::enter()
+{
+    if (!fContext)
+        return false;
+    fPreviousDisplay = glXGetCurrentDisplay();
+    fPreviousDraw = glXGetCurrentDrawable();
+    fPreviousRead = glXGetCurrentReadDrawable();
+    fPrevious = glXGetCurrentContext();
+    return fPrevious == fContext || glXMakeCurrent(fDisplay, fDrawable, fContext);
+}
+
+void ImGuiUI::Impl::GLContext::leave()
+{
+    if (fPrevious == fContext)
+        return;
+    if (fPrevious)
+        glXMakeContextCurrent(fPreviousDisplay, fPreviousDraw, fPreviousRead, fPrevious);
+    else
+        glXMakeCurrent(fDisplay, None, nullptr);
+}
+
+#endif
+
 int ImGuiUI::Impl::mouseButtonToImGui(int button)
 {
     switch (button)
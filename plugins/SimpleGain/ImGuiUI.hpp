@@ -26,6 +26,14 @@ START_NAMESPACE_DGL
 
 /**
    ImGui user interface class.
+
+   The ImGui context and its GL resources exist while the window is shown:
+   they are created at the first display, and released together once the
+   window has been hidden for the release delay (5 s by default, negative
+   to keep them). DPF enters the GL context of the window for the display
+   only, so the release, from idle, enters it through the platform API
+   (GLX, WGL or CGL), as it was current at the last display. The settings
+   of the ImGui windows are kept across a release.
 */
 class ImGuiUI : public UI,
                 public IdleCallback {
@@ -34,9 +42,12 @@ public:
     ~ImGuiUI();
     void setBackgroundColor(Color color);
     void setRepaintInterval(int intervalMs);
+    void setReleaseDelay(int delayMs);
 
 protected:
     virtual void onImGuiDisplay() = 0;
+    // before the context of a hidden window is released
+    virtual void onImGuiRelease() {}
 
 protected:
     virtual void onDisplay() override;
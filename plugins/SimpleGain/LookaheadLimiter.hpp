@@ -0,0 +1,208 @@
+/**
+ * Stereo-linked lookahead brickwall limiter
+ *
+ * The signal is delayed by the lookahead time. The required gain at each
+ * sample is the minimum over a window of lookahead + 1 samples, obtained as a
+ * sliding-window maximum of the peak level (monotonic deque over a ring,
+ * O(1) amortized). It goes through an instant-attack release filter, then a
+ * moving average as long as the lookahead, which ramps the gain down before
+ * a peak without ever letting it exceed the ceiling.
+ *
+ * While the limiter is bypassed, feed() keeps the delay line current, so
+ * that resume() starts it from the recent input, as if it had been running,
+ * and the delayed input is there for a crossfade with the limited signal,
+ * aligned with it.
+ *
+ * The buffers are inline, long enough for 1.5 ms at 384 kHz; a longer
+ * lookahead is cut to that. Nothing is ever allocated.
+ */
+
+#ifndef LOOKAHEAD_LIMITER_H
+#define LOOKAHEAD_LIMITER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+
+class LookaheadLimiter {
+public:
+    enum { kMaxDelay = 576 };
+
+    LookaheadLimiter(float lookaheadMs = 1.5f, float releaseMs = 50.0f)
+        : lookahead(lookaheadMs), release(releaseMs)
+    {
+        setSampleRate(44100.0);
+    }
+
+    /**
+      Compute the delay and time constants. Call prepare() afterwards.
+    */
+    void setSampleRate(double samplingRate) {
+        fs = samplingRate;
+        delay = (uint32_t)ceil(lookahead * 0.001 * samplingRate);
+        if (delay < 1)
+            delay = 1;
+        if (delay > kMaxDelay)
+            delay = kMaxDelay;
+        releaseCoef = 1.0f - expf(-1.0f / (release * 0.001f * (float)samplingRate));
+    }
+
+    /**
+      Set up the buffers for the current sample rate and clear the state.
+    */
+    void prepare() {
+        prepared = delay;
+        reset();
+    }
+
+    void reset() {
+        std::fill(delayL, delayL + delay, 0.0f);
+        std::fill(delayR, delayR + delay, 0.0f);
+        std::fill(box, box + delay, 1.0f);
+        boxSum = delay;
+        env = 1.0f;
+        pos = 0;
+        time = 0;
+        dequeHead = 0;
+        dequeSize = 0;
+    }
+
+    /**
+      Restart the gain from the input kept in the delay line, which feed()
+      keeps current while the limiter is bypassed.
+    */
+    void resume() {
+        std::fill(box, box + delay, 1.0f);
+        boxSum = delay;
+        env = 1.0f;
+        time = 0;
+        dequeHead = 0;
+        dequeSize = 0;
+
+        // the detector over the kept input, oldest first, ending where the
+        // next sample goes
+        uint32_t p = pos;
+        for (uint32_t k = 0; k < delay; ++k) {
+            detect(fmaxf(fabsf(delayL[p]), fabsf(delayR[p])), p);
+            p = (p + 1 < delay) ? (p + 1) : 0;
+            ++time;
+        }
+    }
+
+    /**
+      Keep the delay line current with a block of input, while bypassed.
+    */
+    void feed(const float* left, const float* right, uint32_t frames) {
+        if (prepared != delay)
+            return;
+        for (uint32_t i = (frames > delay) ? (frames - delay) : 0; i < frames; ++i) {
+            delayL[pos] = left[i];
+            delayR[pos] = right[i];
+            pos = (pos + 1 < delay) ? (pos + 1) : 0;
+        }
+    }
+
+    uint32_t getLatency() const { return delay; }
+
+    void setCeiling(float linearCeiling) { ceiling = linearCeiling; }
+
+    /**
+      Process a stereo block in place.
+    */
+    void process(float* left, float* right, uint32_t frames) {
+        run<false>(left, right, frames, nullptr, nullptr);
+    }
+
+    /**
+      Process a stereo block in place, and give the input as delayed, the
+      other side of a crossfade.
+    */
+    void process(float* left, float* right, uint32_t frames, float* delayedLeft, float* delayedRight) {
+        run<true>(left, right, frames, delayedLeft, delayedRight);
+    }
+
+private:
+    template <bool Delayed>
+    void run(float* left, float* right, uint32_t frames, float* delayedLeft, float* delayedRight) {
+        if (prepared != delay)
+            return;  // not prepared for this sample rate
+
+        const float invDelay = 1.0f / (float)delay;
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            const float l = left[i], r = right[i];
+            const float gain = (float)detect(fmaxf(fabsf(l), fabsf(r)), pos) * invDelay;
+
+            // delay line
+            const float dl = delayL[pos], dr = delayR[pos];
+            delayL[pos] = l;
+            delayR[pos] = r;
+            pos = (pos + 1 < delay) ? (pos + 1) : 0;
+            ++time;
+
+            left[i] = fmaxf(-ceiling, fminf(ceiling, dl * gain));
+            right[i] = fmaxf(-ceiling, fminf(ceiling, dr * gain));
+            if (Delayed) {
+                delayedLeft[i] = dl;
+                delayedRight[i] = dr;
+            }
+        }
+    }
+
+    /**
+      Take the peak of the sample at this time, and return the sum of the
+      gains over the lookahead, to be divided by the delay.
+    */
+    double detect(float peak, uint32_t p) {
+        const uint32_t window = delay + 1;
+
+        // sliding-window maximum: values in the deque are decreasing.
+        // expire the front first, so the ring never holds more than
+        // one window of entries
+        if (dequeSize > 0 && time - dequeTime[dequeHead] >= window) {
+            dequeHead = (dequeHead + 1 < window) ? (dequeHead + 1) : 0;
+            --dequeSize;
+        }
+        while (dequeSize > 0 && dequeValue[back()] <= peak)
+            --dequeSize;
+        dequeValue[slot(dequeSize)] = peak;
+        dequeTime[slot(dequeSize)] = time;
+        ++dequeSize;
+        const float windowPeak = dequeValue[dequeHead];
+
+        // required gain, instant attack and smooth release
+        const float target = (windowPeak > ceiling) ? (ceiling / windowPeak) : 1.0f;
+        env = (target < env) ? target : (env + (target - env) * releaseCoef);
+
+        // moving average over the lookahead
+        boxSum += (double)env - (double)box[p];
+        box[p] = env;
+        return boxSum;
+    }
+
+    uint32_t slot(uint32_t offset) const {
+        uint32_t index = dequeHead + offset;
+        return (index < delay + 1) ? index : (index - (delay + 1));
+    }
+
+    uint32_t back() const { return slot(dequeSize - 1); }
+
+    float lookahead, release;
+    float ceiling = 1.0f;
+    float releaseCoef = 0.0f;
+    float env = 1.0f;
+    double fs = 0.0;
+    double boxSum = 0.0;
+    uint32_t delay = 1;
+    uint32_t prepared = 0;
+    uint32_t pos = 0;
+    uint32_t time = 0;
+    uint32_t dequeHead = 0;
+    uint32_t dequeSize = 0;
+
+    float delayL[kMaxDelay], delayR[kMaxDelay], box[kMaxDelay];
+    float dequeValue[kMaxDelay + 1];
+    uint32_t dequeTime[kMaxDelay + 1];
+};
+
+#endif  // #ifndef LOOKAHEAD_LIMITER_H
@@ -0,0 +1,75 @@
+/**
+ * A set of parameter changes, to be applied together
+ *
+ * The changes which arrive between two frames of the editor are collected
+ * here and applied once, before the frame is drawn. A parameter changed
+ * several times is applied once, with its last value, at the place of its
+ * first change; the others keep the order in which they arrived. It holds
+ * at most one entry per parameter, so it never allocates nor grows.
+ */
+
+#ifndef PARAMETER_CHANGE_SET_H
+#define PARAMETER_CHANGE_SET_H
+
+#include <stdint.h>
+
+template <uint32_t Count>
+class ParameterChangeSet {
+public:
+    enum {
+        kCount = Count,
+    };
+
+    ParameterChangeSet() {
+        for (uint32_t index = 0; index < kCount; ++index)
+            fMarked[index] = false;
+    }
+
+    bool isEmpty() const { return fSize == 0; }
+    uint32_t getSize() const { return fSize; }
+
+    /**
+      Record a change; true if the set was empty, when the first change of
+      a frame is to request it.
+    */
+    bool set(uint32_t index, float value) {
+        if (index >= kCount)
+            return false;
+        const bool first = fSize == 0;
+        fValues[index] = value;
+        if (!fMarked[index]) {
+            fMarked[index] = true;
+            fOrder[fSize++] = index;
+        }
+        return first;
+    }
+
+    /**
+      Apply the changes with apply(index, value), and empty the set.
+    */
+    template <class Apply>
+    void apply(Apply&& apply) {
+        // the set is emptied first, so that a change made by apply is kept
+        uint32_t order[kCount];
+        float values[kCount];
+        const uint32_t size = fSize;
+        for (uint32_t i = 0; i < size; ++i) {
+            const uint32_t index = fOrder[i];
+            order[i] = index;
+            values[i] = fValues[index];
+            fMarked[index] = false;
+        }
+        fSize = 0;
+
+        for (uint32_t i = 0; i < size; ++i)
+            apply(order[i], values[i]);
+    }
+
+private:
+    float fValues[kCount];
+    uint32_t fOrder[kCount];  // the indices, by their first change
+    bool fMarked[kCount];
+    uint32_t fSize = 0;
+};
+
+#endif  // #ifndef PARAMETER_CHANGE_SET_H
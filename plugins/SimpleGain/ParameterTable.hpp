@@ -0,0 +1,112 @@
+/**
+ * Compile-time parameter descriptors, and lookup by symbol
+ *
+ * A plugin describes its parameters once, in a constexpr table; the DPF
+ * parameter information, the range clamping, the normalization and the
+ * widgets of the UI all come from there.
+ *
+ * Symbols are found with a perfect hash computed by the compiler: a seed
+ * for FNV-1a is searched so that every symbol of the table falls in its
+ * own slot of a power-of-two index. A lookup is one hash of the symbol and
+ * one string comparison, whatever the number of parameters.
+ *
+ * http://www.isthe.com/chongo/tech/comp/fnv/
+ */
+
+#ifndef PARAMETER_TABLE_H
+#define PARAMETER_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum ParameterTaper {
+    kTaperLinear,   // continuous, proportional to the position
+    kTaperToggle,   // off below the middle, on above
+};
+
+struct ParameterDescriptor {
+    const char* name;
+    const char* shortName;
+    const char* symbol;
+    const char* unit;
+    float min, max, def;
+    uint32_t hints;
+    ParameterTaper taper;
+
+    constexpr float clamp(float value) const {
+        return (value < min) ? min : (value > max) ? max : value;
+    }
+
+    // position between 0 and 1
+    constexpr float normalize(float value) const {
+        return (taper == kTaperToggle) ? ((value > 0.5f * (min + max)) ? 1.0f : 0.0f)
+                                       : (clamp(value) - min) / (max - min);
+    }
+
+    constexpr float denormalize(float position) const {
+        return (taper == kTaperToggle) ? ((position > 0.5f) ? max : min)
+                                       : min + (max - min) * ((position < 0.0f) ? 0.0f : (position > 1.0f) ? 1.0f : position);
+    }
+};
+
+// -----------------------------------------------------------------------
+
+constexpr uint32_t symbolHash(const char* symbol, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (; *symbol; ++symbol)
+        hash = (hash ^ (uint8_t)*symbol) * 16777619u;
+    return hash ^ (hash >> 15);
+}
+
+/**
+  Perfect hash of the symbols of a table of N descriptors.
+*/
+template <size_t N>
+class SymbolIndex {
+public:
+    static_assert(N > 0 && N < 128, "the slots hold indices as int8_t");
+
+    enum { kSize = (N <= 2) ? 4 : 2 * (1u << (32 - __builtin_clz((unsigned)N - 1))) };
+
+    constexpr explicit SymbolIndex(const ParameterDescriptor (&table)[N])
+        : fTable(table)
+    {
+        // the first seed which puts every symbol in a slot of its own
+        for (uint32_t seed = 0;; ++seed) {
+            if (tryFill(seed)) {
+                fSeed = seed;
+                break;
+            }
+        }
+    }
+
+    /**
+      Index of the parameter with this symbol, or -1.
+    */
+    int find(const char* symbol) const {
+        const int8_t index = fSlots[symbolHash(symbol, fSeed) & (kSize - 1)];
+        return (index >= 0 && strcmp(fTable[index].symbol, symbol) == 0) ? index : -1;
+    }
+
+    constexpr uint32_t getSeed() const { return fSeed; }
+
+private:
+    constexpr bool tryFill(uint32_t seed) {
+        for (size_t s = 0; s < kSize; ++s)
+            fSlots[s] = -1;
+        for (size_t i = 0; i < N; ++i) {
+            int8_t& slot = fSlots[symbolHash(fTable[i].symbol, seed) & (kSize - 1)];
+            if (slot >= 0)
+                return false;
+            slot = (int8_t)i;
+        }
+        return true;
+    }
+
+    const ParameterDescriptor* fTable;
+    uint32_t fSeed = 0;
+    int8_t fSlots[kSize] = {};
+};
+
+#endif  // #ifndef PARAMETER_TABLE_H
@@ -25,25 +25,65 @@
  */
 
 #include "PluginSimpleGain.hpp"
+#include <cstring>
 
 START_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
 
 PluginSimpleGain::PluginSimpleGain()
-    : Plugin(paramCount, presetCount, 0)  // paramCount param(s), presetCount program(s), 0 states
+    : PluginSimpleGain(nullptr)
 {
-    smooth_gain = new CParamSmooth(20.0f, getSampleRate());
+}
+
+PluginSimpleGain::PluginSimpleGain(GainBatch* sharedGains)
+    : Plugin(paramCount, getPresetBank()->getPresetCount(), 1)  // paramCount param(s), the programs of the bank, 1 state
+{
+    const int slot = sharedGains ? sharedGains->acquire() : -1;
+    if (slot >= 0) {
+        fGains = sharedGains;
+        fGainSlot = (uint32_t)slot;
+    } else {
+        fGains = &fOwnGains;
+        fGainSlot = (uint32_t)fOwnGains.acquire();
+    }
+
+    fSampleRate = getSampleRate();
+    fGains->setSampleRate(fGainSlot, fSampleRate);
+    fLimiter.setSampleRate(fSampleRate);
+    fSaturationEnabled = false;
+    fLimiterEnabled = false;
+    fTruePeak[0].setSampleRate(fSampleRate);
+    fTruePeak[1].setSampleRate(fSampleRate);
+    fLoadMeter.setSampleRate(fSampleRate);
+    fLoadUpdateFrames = 0;
+
+    // an empty exchange, and a fade of 512 frames, some 10 ms
+    fProgramWrite = 0;
+    fProgramRead = 1;
+    fProgramExchange.store(2, std::memory_order_relaxed);
+    fProgramOverrides.store(0, std::memory_order_relaxed);
+    fFadeFromSaturation = false;
+    fFadeFromLimiter = false;
+    fFade.setLength(512);
+    fSession = SessionSettings();
+    fSession.crossfade = fFade.getLength();
+    fSessionApplied.store(0, std::memory_order_relaxed);
+    fUiLayout.store(0, std::memory_order_relaxed);
 
     for (unsigned p = 0; p < paramCount; ++p) {
-        Parameter param;
-        initParameter(p, param);
-        setParameterValue(p, param.ranges.def);
+        fParams[p] = kParameterDescriptors[p].def;
+        applyParameter(p, fParams[p]);
     }
+
+    // opt-in recording of the host calls, see HostTrace.hpp
+    fTrace = HostTraceRecorder::createFromEnvironment(fSampleRate, getBufferSize());
 }
 
 PluginSimpleGain::~PluginSimpleGain() {
-    delete smooth_gain;
+    delete fTrace;
+    if (fGains != &fOwnGains)
+        fGains->release(fGainSlot);
 }
 
 // -----------------------------------------------------------------------
@@ -53,19 +93,19 @@ void PluginSimpleGain::initParameter(uint32_t index, Parameter& parameter) {
     if (index >= paramCount)
         return;
 
-    parameter.ranges.min = -90.0f;
-    parameter.ranges.max = 30.0f;
-    parameter.ranges.def = -0.0f;
-    parameter.unit = "db";
-    parameter.hints = kParameterIsAutomable;
+    const ParameterDescriptor& descriptor = kParameterDescriptors[index];
+    parameter.name = descriptor.name;
+    parameter.shortName = descriptor.shortName;
+    parameter.symbol = descriptor.symbol;
+    parameter.unit = descriptor.unit;
+    parameter.ranges.min = descriptor.min;
+    parameter.ranges.max = descriptor.max;
+    parameter.ranges.def = descriptor.def;
+    parameter.hints = descriptor.hints;
+}
 
-    switch (index) {
-        case paramGain:
-            parameter.name = "Gain (dB)";
-            parameter.shortName = "Gain";
-            parameter.symbol = "gain";
-            break;
-    }
+int PluginSimpleGain::findParameterBySymbol(const char* symbol) {
+    return kParameterSymbols.find(symbol);
 }
 
 /**
@@ -73,8 +113,20 @@ void PluginSimpleGain::initParameter(uint32_t index, Parameter& parameter) {
   This function will be called once, shortly after the plugin is created.
 */
 void PluginSimpleGain::initProgramName(uint32_t index, String& programName) {
-    if (index < presetCount) {
-        programName = factoryPresets[index].name;
+    const PresetBankReader bank = getPresetBank();
+    if (index < bank->getPresetCount()) {
+        programName = bank->getPresetName(index);
+    }
+}
+
+/**
+  Set the key and the default value of the state @a index.
+  This function will be called once, shortly after the plugin is created.
+*/
+void PluginSimpleGain::initState(uint32_t index, String& stateKey, String& defaultStateValue) {
+    if (index == 0) {
+        stateKey = "session";
+        defaultStateValue = "";
     }
 }
 
@@ -85,8 +137,17 @@ void PluginSimpleGain::initProgramName(uint32_t index, String& programName) {
   Optional callback to inform the plugin about a sample rate change.
 */
 void PluginSimpleGain::sampleRateChanged(double newSampleRate) {
+    if (fTrace)
+        fTrace->recordSampleRate(newSampleRate);
+
     fSampleRate = newSampleRate;
-    smooth_gain->setSampleRate(newSampleRate);
+    fGains->setSampleRate(fGainSlot, newSampleRate);
+    fLimiter.setSampleRate(newSampleRate);
+    fLimiter.prepare();
+    fTruePeak[0].setSampleRate(newSampleRate);
+    fTruePeak[1].setSampleRate(newSampleRate);
+    fLoadMeter.setSampleRate(newSampleRate);
+    updateLatency();
 }
 
 /**
@@ -100,33 +161,447 @@ float PluginSimpleGain::getParameterValue(uint32_t index) const {
   Change a parameter value.
 */
 void PluginSimpleGain::setParameterValue(uint32_t index, float value) {
+    if (fTrace)
+        fTrace->recordParameter(index, value);
+
+    updateParameter(index, value);
+
+    // not to be undone by a program which run() has yet to apply
+    if (!isOutputParameter(index))
+        fProgramOverrides.fetch_or(1u << index, std::memory_order_relaxed);
+}
+
+/**
+  Apply a parameter value, without recording it as a host call.
+*/
+void PluginSimpleGain::updateParameter(uint32_t index, float value) {
+    const bool moved = value != fParams[index];
     fParams[index] = value;
 
+    if (index == paramMorph) {
+        if (moved)
+            updateMorph();
+    } else {
+        applyParameter(index, value);
+    }
+}
+
+/**
+  Drive the DSP with a parameter value.
+*/
+void PluginSimpleGain::applyParameter(uint32_t index, float value) {
     switch (index) {
         case paramGain:
-            gain = DB_CO(CLAMP(fParams[paramGain], -90.0, 30.0));
+            fGains->setTarget(fGainSlot, DB_CO(kParameterDescriptors[paramGain].clamp(value)));
+            break;
+        case paramSaturation:
+            setSaturationEnabled(value > 0.5f);
+            break;
+        case paramLimiter:
+            setLimiterEnabled(value > 0.5f);
+            break;
+        case paramCeiling:
+            fLimiter.setCeiling(DB_CO(kParameterDescriptors[paramCeiling].clamp(value)));
+            break;
+        case paramAbSlot:
+            if (const float* values = fAbSlots.select((uint32_t)(kParameterDescriptors[paramAbSlot].clamp(value) + 0.5f), fParams))
+                prepareProgram(values);
             break;
     }
 }
 
+/**
+  Hand run() the program parameters at the morph position.
+*/
+void PluginSimpleGain::updateMorph() {
+    if (fMorph.isActive())
+        publishLiveProgram();
+}
+
+void PluginSimpleGain::setMorphSnapshot(uint32_t index, const float* values) noexcept {
+    const bool active = fMorph.isActive();
+    fMorph.setSnapshot(index, values);
+    if (fMorph.isActive() != active)
+        publishLiveProgram();
+}
+
+void PluginSimpleGain::clearMorphSnapshots() noexcept {
+    const bool active = fMorph.isActive();
+    fMorph.clear();
+    if (active)
+        publishLiveProgram();
+}
+
+// A stage starts from a clean state when it is turned on; when it is
+// turned off, its state is left as is for a crossfade to finish with it.
+void PluginSimpleGain::setSaturationEnabled(bool enabled) {
+    if (fSaturationEnabled != enabled) {
+        fSaturationEnabled = enabled;
+        if (enabled) {
+            fClipper[0].reset();
+            fClipper[1].reset();
+        }
+    }
+}
+
+void PluginSimpleGain::setLimiterEnabled(bool enabled) {
+    if (fLimiterEnabled != enabled) {
+        fLimiterEnabled = enabled;
+        if (enabled)
+            fLimiter.resume();
+        updateLatency();
+    }
+}
+
+/**
+  Report the processing delay to the host, which depends on the limiter.
+*/
+void PluginSimpleGain::updateLatency() {
+    setLatency(getLatencyFrames());
+}
+
 /**
   Load a program.
   The host may call this function from any context,
   including realtime processing.
 */
 void PluginSimpleGain::loadProgram(uint32_t index) {
-    if (index < presetCount) {
-        for (int i=0; i < paramCount; i++) {
-            setParameterValue(i, factoryPresets[index].params[i]);
+    if (fTrace)
+        fTrace->recordProgram(index);
+
+    // the values are read in place, and the columns of the bank are the
+    // program parameters, in order
+    const PresetBankReader bank = getPresetBank();
+    if (index >= bank->getPresetCount())
+        return;
+
+    prepareProgram(bank->getPresetValues(index));
+}
+
+/**
+  Make the values of the program parameters live, and hand them to run().
+*/
+void PluginSimpleGain::prepareProgram(const float* values) {
+    for (uint32_t i = 0; i < paramMorph; i++)
+        fParams[i] = values[i];
+
+    publishProgram(values);
+}
+
+/**
+  Hand values of the program parameters to run(), with the latest session
+  settings; the parameters stay as they are.
+*/
+void PluginSimpleGain::publishProgram(const float* values) {
+    ProgramSnapshot& program = fPrograms[fProgramWrite];
+    program.gain = DB_CO(kParameterDescriptors[paramGain].clamp(values[paramGain]));
+    program.ceiling = DB_CO(kParameterDescriptors[paramCeiling].clamp(values[paramCeiling]));
+    program.saturation = values[paramSaturation] > 0.5f;
+    program.limiter = values[paramLimiter] > 0.5f;
+    program.session = fSession;
+
+    fProgramOverrides.store(0, std::memory_order_relaxed);
+    fProgramWrite = fProgramExchange.exchange(fProgramWrite | kProgramDirty, std::memory_order_acq_rel) & ~kProgramDirty;
+}
+
+/**
+  Hand run() the values which drive the DSP now: those at the morph
+  position, or else the parameters.
+*/
+void PluginSimpleGain::publishLiveProgram() {
+    if (!fMorph.isActive()) {
+        publishProgram(fParams);
+        return;
+    }
+
+    alignas(16) float values[MorphSnapshots::kStride];
+    fMorph.interpolate(kParameterDescriptors[paramMorph].normalize(fParams[paramMorph]), values);
+    publishProgram(values);
+}
+
+/**
+  Add to the settings which the next program carries. Those which run()
+  has yet to apply are kept with the new ones.
+*/
+void PluginSimpleGain::stageSessionSettings(uint32_t fields, uint32_t crossfade, const float* meters) {
+    if (fSessionApplied.load(std::memory_order_acquire) == fSession.serial)
+        fSession.fields = 0;
+
+    if (fields & kSessionCrossfade)
+        fSession.crossfade = crossfade;
+    if (fields & kSessionMeters) {
+        fSession.meters[0] = meters[0];
+        fSession.meters[1] = meters[1];
+    }
+    fSession.fields |= fields;
+    ++fSession.serial;
+}
+
+void PluginSimpleGain::setProgramCrossfade(uint32_t frames) noexcept {
+    stageSessionSettings(kSessionCrossfade, frames, nullptr);
+    publishLiveProgram();
+}
+
+void PluginSimpleGain::applySessionSettings(const SessionSettings& session) {
+    if (session.serial == fSessionApplied.load(std::memory_order_relaxed))
+        return;
+
+    if (session.fields & kSessionCrossfade)
+        fFade.setLength(session.crossfade);
+    if (session.fields & kSessionMeters) {
+        fTruePeak[0].setLevel(session.meters[0]);
+        fTruePeak[1].setLevel(session.meters[1]);
+    }
+    fSessionApplied.store(session.serial, std::memory_order_release);
+}
+
+/**
+  Apply a program at the start of a block, but for the parameters which
+  were set after it was loaded.
+*/
+void PluginSimpleGain::applyProgram(const ProgramSnapshot& program, uint32_t overrides) {
+    // the crossfade length first, for the fade of this program
+    applySessionSettings(program.session);
+
+    const bool saturation = (overrides & (1u << paramSaturation)) ? fSaturationEnabled : program.saturation;
+    const bool limiter = (overrides & (1u << paramLimiter)) ? fLimiterEnabled : program.limiter;
+
+    if (fFade.getLength() > 0 && (saturation != fSaturationEnabled || limiter != fLimiterEnabled)) {
+        fFadeFromSaturation = fSaturationEnabled;
+        fFadeFromLimiter = fLimiterEnabled;
+        fFade.start();
+    }
+
+    if (!(overrides & (1u << paramGain)))
+        fGains->setTarget(fGainSlot, program.gain);
+    if (!(overrides & (1u << paramCeiling)))
+        fLimiter.setCeiling(program.ceiling);
+    setSaturationEnabled(saturation);
+    setLimiterEnabled(limiter);
+}
+
+// -----------------------------------------------------------------------
+// Session state
+
+std::vector<uint8_t> PluginSimpleGain::saveState() const {
+    StateWriter writer;
+
+    // before the parameters, for the slot and the morph to be applied
+    // once they are
+    writer.beginField(kStateAbSlots);
+    fAbSlots.write(writer, fParams);
+    writer.endField();
+
+    if (fMorph.getSnapshotCount() > 0) {
+        writer.beginField(kStateMorphSnapshots);
+        writer.writeVarint(fMorph.getSnapshotCount());
+        for (uint32_t s = 0; s < fMorph.getSnapshotCount(); ++s) {
+            for (uint32_t index = 0; index < paramMorph; ++index)
+                writer.writeFloat(fMorph.getSnapshot(s)[index]);
         }
+        writer.endField();
+    }
+
+    writer.beginField(kStateParameters);
+    for (uint32_t index = 0; index < paramCount; ++index) {
+        if (isOutputParameter(index))
+            continue;
+        writer.writeVarint(index);
+        writer.writeFloat(fParams[index]);
+    }
+    writer.endField();
+
+    writer.beginField(kStateMeters);
+    writer.writeFloat(fTruePeak[0].getLevel());
+    writer.writeFloat(fTruePeak[1].getLevel());
+    writer.endField();
+
+    writer.beginField(kStateProgramCrossfade);
+    writer.writeVarint(fSession.crossfade);
+    writer.endField();
+
+    uint32_t width, height;
+    if (getUiLayout(width, height)) {
+        writer.beginField(kStateUiLayout);
+        writer.writeVarint(width);
+        writer.writeVarint(height);
+        writer.endField();
+    }
+
+    return writer.finish();
+}
+
+/**
+  Apply the fields of a state. A state which fails its checksum, is of
+  another version, or has a field which does not read changes nothing.
+*/
+bool PluginSimpleGain::loadState(const uint8_t* data, size_t size) {
+    StateReader reader;
+    if (!reader.open(data, size))
+        return false;
+
+    // what the state changes, decoded in full before any of it is applied
+    struct Staged {
+        uint32_t fields = 0;      // a bit per tag
+        uint32_t parameters = 0;  // a bit per parameter
+        float values[paramCount];
+        float meters[2];
+        uint32_t crossfade;
+        uint32_t width, height;
+        MorphSnapshots morph;
+        AbSlotSet abSlots;
+    } staged;
+
+    uint32_t tag;
+    StateReader field;
+    while (!reader.atEnd()) {
+        if (!reader.nextField(tag, field))
+            return false;
+
+        switch (tag) {
+        case kStateParameters:
+            while (!field.atEnd()) {
+                uint32_t index;
+                float value;
+                if (!field.readVarint(index) || !field.readFloat(value))
+                    return false;
+                if (index < paramCount && !isOutputParameter(index)) {
+                    staged.values[index] = value;
+                    staged.parameters |= 1u << index;
+                }
+            }
+            break;
+        case kStateMeters:
+            if (!field.readFloat(staged.meters[0]) || !field.readFloat(staged.meters[1]))
+                return false;
+            break;
+        case kStateProgramCrossfade:
+            if (!field.readVarint(staged.crossfade))
+                return false;
+            break;
+        case kStateUiLayout:
+            if (!field.readVarint(staged.width) || !field.readVarint(staged.height))
+                return false;
+            break;
+        case kStateAbSlots:
+            staged.abSlots = fAbSlots;
+            if (!staged.abSlots.read(field))
+                return false;
+            break;
+        case kStateMorphSnapshots: {
+            uint32_t count;
+            if (!field.readVarint(count) || count > kMorphSnapshots)
+                return false;
+            staged.morph.clear();
+            for (uint32_t s = 0; s < count; ++s) {
+                float values[paramMorph];
+                for (uint32_t index = 0; index < paramMorph; ++index) {
+                    if (!field.readFloat(values[index]))
+                        return false;
+                }
+                staged.morph.setSnapshot(s, values);
+            }
+            break;
+        }
+        default:
+            continue;  // from a newer plugin
+        }
+        staged.fields |= 1u << tag;
+    }
+
+    // the slot first, the parameters of the state then replace the values
+    // which it makes live
+    if (staged.fields & (1u << kStateAbSlots)) {
+        fAbSlots = staged.abSlots;
+        fParams[paramAbSlot] = (float)fAbSlots.getActive();
+    } else if (staged.parameters & (1u << paramAbSlot)) {
+        const uint32_t slot = (uint32_t)(kParameterDescriptors[paramAbSlot].clamp(staged.values[paramAbSlot]) + 0.5f);
+        if (const float* values = fAbSlots.select(slot, fParams))
+            std::memcpy(fParams, values, paramMorph * sizeof(float));
+        fParams[paramAbSlot] = staged.values[paramAbSlot];
+    }
+    staged.parameters &= ~(1u << paramAbSlot);
+
+    for (uint32_t index = 0; index < paramCount; ++index) {
+        if (staged.parameters & (1u << index))
+            fParams[index] = staged.values[index];
+    }
+    if (staged.fields & (1u << kStateMorphSnapshots))
+        fMorph = staged.morph;
+    if (staged.fields & (1u << kStateUiLayout))
+        setUiLayout(staged.width, staged.height);
+
+    uint32_t settings = 0;
+    if (staged.fields & (1u << kStateProgramCrossfade))
+        settings |= kSessionCrossfade;
+    if (staged.fields & (1u << kStateMeters))
+        settings |= kSessionMeters;
+    if (settings)
+        stageSessionSettings(settings, staged.crossfade, staged.meters);
+
+    // the layout alone leaves the DSP as it is
+    if (staged.fields & ~(1u << kStateUiLayout))
+        publishLiveProgram();
+    return true;
+}
+
+String PluginSimpleGain::getState(const char* key) const {
+    if (std::strcmp(key, "session") != 0)
+        return String();
+    const std::vector<uint8_t> state = saveState();
+    return String(encodeBase64(state.data(), state.size()).c_str());
+}
+
+/**
+  Change an internal state @a key to @a value.
+*/
+void PluginSimpleGain::setState(const char* key, const char* value) {
+    if (std::strcmp(key, "session") != 0)
+        return;
+
+    // a state from the editor may come on the realtime thread, and those
+    // are decoded on the stack; a whole session, from the host, may not
+    uint8_t inlineState[kInlineStateSize];
+    size_t size;
+    if (std::strlen(value) / 4 * 3 + 2 <= sizeof(inlineState)) {
+        if (decodeBase64(value, inlineState, sizeof(inlineState), size))
+            loadState(inlineState, size);
+        return;
     }
+
+    std::vector<uint8_t> state;
+    if (decodeBase64(value, state))
+        loadState(state.data(), state.size());
 }
 
 // -----------------------------------------------------------------------
 // Process
 
 void PluginSimpleGain::activate() {
-    // plugin is activated
+    if (fTrace)
+        fTrace->recordActivate();
+
+    // plugin is activated, start from the same state as a new instance
+    fGains->reset(fGainSlot);
+    fClipper[0].reset();
+    fClipper[1].reset();
+    fLimiter.prepare();
+    fTruePeak[0].reset();
+    fTruePeak[1].reset();
+    fLoadMeter.reset();
+    fLoadUpdateFrames = 0;
+    fFade.stop();
+}
+
+/**
+  Publish the load statistics as output parameters, a few times per second.
+*/
+void PluginSimpleGain::updateLoadParameters() {
+    const DspLoadMeter::Summary load = fLoadMeter.getSummary();
+    fParams[paramLoadP50] = (float)(100.0 * load.p50);
+    fParams[paramLoadP99] = (float)(100.0 * load.p99);
+    fParams[paramLoadP999] = (float)(100.0 * load.p999);
+    fParams[paramLoadMax] = (float)(100.0 * load.max);
 }
 
 
@@ -134,22 +609,177 @@ void PluginSimpleGain::activate() {
 void PluginSimpleGain::run(const float** inputs, float** outputs,
                            uint32_t frames) {
 
-    // get the left and right audio inputs
-    const float* const inpL = inputs[0];
-    const float* const inpR = inputs[1];
+    if (fTrace)
+        fTrace->recordRun(frames);
+
+#if SIMPLEGAIN_DSP_LOAD
+    const uint64_t startTicks = DspLoadMeter::now();
+#endif
+
+    // a program loaded since the last block
+    if (fProgramExchange.load(std::memory_order_relaxed) & kProgramDirty) {
+        fProgramRead = fProgramExchange.exchange(fProgramRead, std::memory_order_acq_rel) & ~kProgramDirty;
+        applyProgram(fPrograms[fProgramRead], fProgramOverrides.exchange(0, std::memory_order_relaxed));
+    }
 
     // get the left and right audio outputs
     float* const outL = outputs[0];
     float* const outR = outputs[1];
 
     // apply gain against all samples
+    fGains->processSlot(fGainSlot, inputs, outputs, frames);
+
+    if (fFade.isActive()) {
+        runCrossfade(outL, outR, frames);
+    } else {
+        if (fSaturationEnabled) {
+            fClipper[0].process(outL, frames);
+            fClipper[1].process(outR, frames);
+        }
+
+        if (fLimiterEnabled)
+            fLimiter.process(outL, outR, frames);
+        else
+            fLimiter.feed(outL, outR, frames);
+    }
+
+    // true-peak meters on the output, read back by the host as output parameters
+    fParams[paramTruePeakLeft] = fTruePeak[0].process(outL, frames);
+    fParams[paramTruePeakRight] = fTruePeak[1].process(outR, frames);
+
+#if SIMPLEGAIN_DSP_LOAD
+    fLoadMeter.record(startTicks, frames);
+    if (fLoadUpdateFrames <= frames) {
+        updateLoadParameters();
+        fLoadUpdateFrames = (uint32_t)(fSampleRate / 10);
+    } else {
+        fLoadUpdateFrames -= frames;
+    }
+#endif
+}
+
+/**
+  Process the stages after a program change. A stage which changed mode
+  fades between its own output and its input, the one leaving with the
+  old mode and the other coming with the new; the rest of the block after
+  the end of the fade is processed in the new modes. The limiter fades
+  against its delayed input, so a fade which turns it off ends on the
+  delayed signal, and the next block takes the latency away at once, as
+  the host was told when the fade started.
+*/
+void PluginSimpleGain::runCrossfade(float* outL, float* outR, uint32_t frames) {
+    float fadeOut[kFadeChunkSize];
+    float fadeIn[kFadeChunkSize];
+    float inputL[kFadeChunkSize];
+    float inputR[kFadeChunkSize];
+
+    // process gives the other side of the fade, its input as it would come
+    // out of the stage bypassed
+    const auto stage = [&](bool from, bool to, float* left, float* right, uint32_t count, auto&& process) {
+        if (from == to) {
+            if (to)
+                process(left, right, count, nullptr, nullptr);
+            return;
+        }
+        process(left, right, count, inputL, inputR);
+        const float* const processedGain = to ? fadeIn : fadeOut;
+        const float* const bypassedGain = to ? fadeOut : fadeIn;
+        for (uint32_t i = 0; i < count; ++i) {
+            left[i] = left[i] * processedGain[i] + inputL[i] * bypassedGain[i];
+            right[i] = right[i] * processedGain[i] + inputR[i] * bypassedGain[i];
+        }
+    };
+
+    for (uint32_t offset = 0; offset < frames; offset += kFadeChunkSize) {
+        const uint32_t count = MIN(frames - offset, (uint32_t)kFadeChunkSize);
+        float* const left = outL + offset;
+        float* const right = outR + offset;
+        fFade.next(fadeOut, fadeIn, count);
+
+        stage(fFadeFromSaturation, fSaturationEnabled, left, right, count,
+              [this](float* l, float* r, uint32_t n, float* bypassL, float* bypassR) {
+                  if (bypassL) {
+                      std::memcpy(bypassL, l, n * sizeof(float));
+                      std::memcpy(bypassR, r, n * sizeof(float));
+                  }
+                  fClipper[0].process(l, n);
+                  fClipper[1].process(r, n);
+              });
+        // the limiter delays its signal by the lookahead, and the bypassed
+        // side by as much, from its delay line, or the fade would sum two
+        // copies of the signal apart in time
+        stage(fFadeFromLimiter, fLimiterEnabled, left, right, count,
+              [this](float* l, float* r, uint32_t n, float* bypassL, float* bypassR) {
+                  if (bypassL)
+                      fLimiter.process(l, r, n, bypassL, bypassR);
+                  else
+                      fLimiter.process(l, r, n);
+              });
+        if (!fFadeFromLimiter && !fLimiterEnabled)
+            fLimiter.feed(left, right, count);
+    }
+}
+
+// -----------------------------------------------------------------------
+// Resuming
+
+void PluginSimpleGain::skipFrames(uint32_t frames) noexcept {
     for (uint32_t i=0; i < frames; ++i) {
-        float gainval = smooth_gain->process(gain);
-        outL[i] = inpL[i] * gainval;
-        outR[i] = inpR[i] * gainval;
+        const float previous = fGains->getState(fGainSlot);
+        if (fGains->step(fGainSlot) == previous)
+            break;  // settled, the next frames leave it unchanged
     }
 }
 
+void PluginSimpleGain::resume(float smoothedGain, float previousLeft,
+                              float previousRight) noexcept {
+    // the same products as in run()
+    fGains->setState(fGainSlot, smoothedGain);
+    fClipper[0].setPrevious(previousLeft * smoothedGain);
+    fClipper[1].setPrevious(previousRight * smoothedGain);
+}
+
+void PluginSimpleGain::resetMeterLevels() noexcept {
+    fTruePeak[0].resetLevel();
+    fTruePeak[1].resetLevel();
+    fParams[paramTruePeakLeft] = fTruePeak[0].getLevel();
+    fParams[paramTruePeakRight] = fTruePeak[1].getLevel();
+}
+
+// -----------------------------------------------------------------------
+// Memory layout
+
+void PluginSimpleGain::writeMemoryReport(FILE* file) const {
+    const char* const base = (const char*)this;
+    fprintf(file, "PluginSimpleGain: %zu bytes, aligned to %zu, at %p\n",
+            sizeof(*this), alignof(PluginSimpleGain), (const void*)this);
+    fprintf(file, "%8s %8s %9s  %s\n", "offset", "size", "lines", "contents");
+
+    const auto row = [&](const char* name, const void* begin, const void* end) {
+        // the object is aligned to a cache line
+        const size_t offset = (const char*)begin - base;
+        const size_t size = (const char*)end - (const char*)begin;
+        char lines[48];
+        snprintf(lines, sizeof(lines), "%zu-%zu", offset / 64, (offset + size - 1) / 64);
+        fprintf(file, "%8zu %8zu %9s  %s\n", offset, size, lines, name);
+    };
+
+    row("Plugin (vtable, framework data)", base, base + sizeof(Plugin));
+    row("per call: gain slot, trace, modes, program exchange, rate, fade", &fGains, &fFade + 1);
+    row("per sample: gain smoother and clipper state", &fOwnGains, &fClipper[2]);
+    row("parameters", &fParams[0], &fParams[paramCount]);
+    row("program snapshots", &fPrograms[0], &fProgramOverrides + 1);
+    row("true-peak meters", &fTruePeak[0], &fTruePeak[2]);
+    row("limiter", &fLimiter, &fLimiter + 1);
+    row("load meter", &fLoadMeter, &fLoadMeter + 1);
+    row("morph snapshots", &fMorph, &fMorph + 1);
+    row("A/B slots", &fAbSlots, &fAbSlots + 1);
+    row("session: settings, UI layout", &fSession, &fUiLayout + 1);
+
+    if (fGains != &fOwnGains)
+        fprintf(file, "gain stage in slot %u of a shared batch\n", fGainSlot);
+}
+
 // -----------------------------------------------------------------------
 
 Plugin* createPlugin() {
@@ -28,7 +28,20 @@
 #define PLUGIN_SIMPLEGAIN_H
 
 #include "DistrhoPlugin.hpp"
-#include "CParamSmooth.hpp"
+#include "GainBatch.hpp"
+#include "TruePeakMeter.hpp"
+#include "LookaheadLimiter.hpp"
+#include "ADAAClipper.hpp"
+#include "HostTrace.hpp"
+#include "DspLoadMeter.hpp"
+#include "EqualPowerFade.hpp"
+#include "PresetMorph.hpp"
+#include "AbSlots.hpp"
+#include "ParameterTable.hpp"
+#include "PresetBank.hpp"
+#include "EpochReclaimer.hpp"
+#include "SessionState.hpp"
+#include <atomic>
 
 START_NAMESPACE_DISTRHO
 
@@ -44,6 +57,11 @@ START_NAMESPACE_DISTRHO
 #define CLAMP(v, min, max) (MIN((max), MAX((min), (v))))
 #endif
 
+// measure the cost of every run() call, see DspLoadMeter.hpp
+#ifndef SIMPLEGAIN_DSP_LOAD
+#define SIMPLEGAIN_DSP_LOAD 1
+#endif
+
 #ifndef DB_CO
 #define DB_CO(g) ((g) > -90.0f ? powf(10.0f, (g) * 0.05f) : 0.0f)
 #endif
@@ -54,13 +72,173 @@ class PluginSimpleGain : public Plugin {
 public:
     enum Parameters {
         paramGain = 0,
+        paramSaturation,
+        paramLimiter,
+        paramCeiling,
+        paramMorph,
+        paramAbSlot,
+        paramTruePeakLeft,
+        paramTruePeakRight,
+        paramLoadP50,
+        paramLoadP99,
+        paramLoadP999,
+        paramLoadMax,
         paramCount
     };
 
+    // the output parameters come last
+    static bool isOutputParameter(uint32_t index) {
+        return index >= paramTruePeakLeft && index < paramCount;
+    }
+
+    // the parameters which programs and morph snapshots hold come first
+    static bool isProgramParameter(uint32_t index) {
+        return index < paramMorph;
+    }
+
+    // Index of the parameter with this symbol, or -1
+    static int findParameterBySymbol(const char* symbol);
+
+    // The programs of every instance in the process: the bank of the file
+    // named by SIMPLEGAIN_PRESETS, or else the factory presets. The bank
+    // stays valid for as long as the reader lives.
+    typedef EpochPointer<const PresetBank>::Reader PresetBankReader;
+    static PresetBankReader getPresetBank();
+
+    // Replace the bank of the process, from a thread which is not realtime;
+    // the number of programs stays that of the bank at instantiation. Takes
+    // the bank, and rejects it if its columns are not the parameters.
+    static bool setPresetBank(PresetBank* bank);
+
     PluginSimpleGain();
 
+    // Run the gain stage in a slot of a shared batch, or in a batch of its
+    // own if that one is full; see GainBatch.hpp
+    explicit PluginSimpleGain(GainBatch* sharedGains);
+
     ~PluginSimpleGain();
 
+    uint32_t getGainSlot() const noexcept { return fGainSlot; }
+
+    // Processing delay in frames, as last reported with setLatency()
+    uint32_t getLatencyFrames() const noexcept {
+        return fLimiterEnabled ? fLimiter.getLatency() : 0;
+    }
+
+    // -------------------------------------------------------------------
+    // Resuming a stream at an arbitrary frame, to render it in chunks
+    //
+    // From one frame to the next, the plugin carries the smoothed gain, the
+    // last clipper input and the true-peak filter history. The first two
+    // are restored exactly by resume(), the filter history after
+    // Upsampler4x::kTaps frames. The limiter depends on the whole history
+    // of the signal, it cannot be resumed.
+
+    bool canResume() const noexcept { return !fLimiterEnabled; }
+
+    float getSmoothedGain() const noexcept { return fGains->getState(fGainSlot); }
+
+    // Advance the gain smoother as run() would, without audio
+    void skipFrames(uint32_t frames) noexcept;
+
+    // Restore the state after a frame, given its smoothed gain and input
+    void resume(float smoothedGain, float previousLeft, float previousRight) noexcept;
+
+    void resetMeterLevels() noexcept;
+
+    // -------------------------------------------------------------------
+    // Program changes
+    //
+    // loadProgram() prepares the program and hands it to run(), which
+    // applies it at the start of its next block. The stages which the
+    // program turns on or off then fade from their old mode to the new one
+    // over the crossfade length, in frames; the gain follows its smoother.
+    // The length is handed to run() the same way, from the thread which
+    // sets the parameters.
+
+    void setProgramCrossfade(uint32_t frames) noexcept;
+    uint32_t getProgramCrossfade() const noexcept { return fSession.crossfade; }
+
+    // -------------------------------------------------------------------
+    // Morphing
+    //
+    // The morph parameter moves the program parameters between snapshots,
+    // from the first at 0 to the last at 1; see PresetMorph.hpp. Each time
+    // it moves, the morphed values are handed to run() as a program is,
+    // the stages which they switch with its crossfade, but the parameters
+    // which the host sees stay as they were. With fewer than two
+    // snapshots, it does nothing; the morph turning on or off with the
+    // snapshots crossfades the same way.
+
+    enum { kMorphSnapshots = 8 };
+    typedef PresetMorph<paramMorph, kMorphSnapshots> MorphSnapshots;
+
+    // Set a snapshot from the values of the program parameters, from the
+    // thread which sets the parameters; it is heard when the morph moves
+    void setMorphSnapshot(uint32_t index, const float* values) noexcept;
+    void clearMorphSnapshots() noexcept;
+    const MorphSnapshots& getMorphSnapshots() const noexcept { return fMorph; }
+
+    // -------------------------------------------------------------------
+    // A/B comparison
+    //
+    // The A/B slot parameter selects which of the slots holds the program
+    // parameters; see AbSlots.hpp. The slot selected is applied as a
+    // program is, at the start of the next block with its crossfade, and
+    // only the slot parameter changes for the host.
+
+    enum { kAbSlots = 2 };
+    typedef AbSlots<paramMorph, kAbSlots> AbSlotSet;
+
+    const AbSlotSet& getAbSlots() const noexcept { return fAbSlots; }
+
+    // -------------------------------------------------------------------
+    // Session state
+    //
+    // What an instance holds besides its audio history, as one binary
+    // state (see SessionState.hpp), which hosts store in base64 as the
+    // state "session". A state may hold only some of the fields, like the
+    // one the editor sends with its morph snapshots; the others are left
+    // as they are.
+    //
+    // loadState() decodes the whole state before it changes anything, then
+    // hands what the DSP takes from it to run() as a program, so it may be
+    // called from the thread which sets the parameters, realtime or not.
+    // A state which does not decode in full changes nothing.
+
+    enum StateFields {
+        kStateParameters = 1,   // index and value of each input parameter
+        kStateMeters,           // true-peak levels, in dBTP
+        kStateProgramCrossfade, // frames
+        kStateUiLayout,         // kept for the UI, see UISimpleGain
+        kStateMorphSnapshots,   // count, then the values of each snapshot
+        kStateAbSlots,          // see AbSlots::write
+    };
+
+    std::vector<uint8_t> saveState() const;
+    bool loadState(const uint8_t* data, size_t size);
+
+    // The size of the editor window, saved with the session. The editor
+    // sets it directly, as the window is resized, and no state is sent.
+    void setUiLayout(uint32_t width, uint32_t height) noexcept {
+        if (width > 0 && width <= 0xffff && height > 0 && height <= 0xffff)
+            fUiLayout.store(width << 16 | height, std::memory_order_relaxed);
+    }
+
+    bool getUiLayout(uint32_t& width, uint32_t& height) const noexcept {
+        const uint32_t layout = fUiLayout.load(std::memory_order_relaxed);
+        width = layout >> 16;
+        height = layout & 0xffff;
+        return layout != 0;
+    }
+
+    // -------------------------------------------------------------------
+
+    // Cost of the run() calls since the last activation
+    const DspLoadMeter& getLoadMeter() const noexcept { return fLoadMeter; }
+
+    // Layout of the instance in memory, by cache line
+    void writeMemoryReport(FILE* file) const;
 protected:
     // -------------------------------------------------------------------
     // Information
@@ -103,6 +281,7 @@ protected:
 
     void initParameter(uint32_t index, Parameter& parameter) override;
     void initProgramName(uint32_t index, String& programName) override;
+    void initState(uint32_t index, String& stateKey, String& defaultStateValue) override;
 
     // -------------------------------------------------------------------
     // Internal data
@@ -110,6 +289,8 @@ protected:
     float getParameterValue(uint32_t index) const override;
     void setParameterValue(uint32_t index, float value) override;
     void loadProgram(uint32_t index) override;
+    String getState(const char* key) const override;
+    void setState(const char* key, const char* value) override;
 
     // -------------------------------------------------------------------
     // Optional
@@ -128,31 +309,130 @@ protected:
     // -------------------------------------------------------------------
 
 private:
-    float           fParams[paramCount];
+    // What run() takes from a session state besides the parameters. Every
+    // program carries the latest settings, so that none is lost to a later
+    // program, and run() applies them once per serial.
+    struct SessionSettings {
+        uint32_t serial;
+        uint32_t fields;  // kSessionCrossfade, kSessionMeters
+        uint32_t crossfade;
+        float meters[2];
+    };
+
+    // A program as run() applies it, with the gains already converted
+    struct ProgramSnapshot {
+        float gain;
+        float ceiling;
+        bool saturation;
+        bool limiter;
+        SessionSettings session;
+    };
+
+    enum {
+        kProgramDirty = 4,  // in fProgramExchange, with a snapshot index
+        kFadeChunkSize = 64,
+        kSessionCrossfade = 1,
+        kSessionMeters = 2,
+        kInlineStateSize = 512,  // decoded without allocating, see setState()
+    };
+
+    // The whole DSP state is inline, and the constructor allocates nothing
+    // more than the object. What run() reads on every call is in one cache
+    // line, and what it updates on every sample in the next.
+    alignas(64)
+    GainBatch       *fGains;
+    HostTraceRecorder *fTrace;
+    uint32_t        fGainSlot;
+    uint32_t        fLoadUpdateFrames;
+    bool            fSaturationEnabled;
+    bool            fLimiterEnabled;
+    bool            fFadeFromSaturation;  // the modes before the program
+    bool            fFadeFromLimiter;
+    std::atomic<uint32_t> fProgramExchange;
     double          fSampleRate;
-    float           gain;
-    CParamSmooth    *smooth_gain;
+    EqualPowerFade  fFade;
+
+    alignas(64)
+    FixedGainBatch<1> fOwnGains;
+    ADAAClipper     fClipper[2];
+
+    float           fParams[paramCount];
+
+    // Triple buffer: loadProgram() fills the write snapshot then exchanges
+    // it with the one in fProgramExchange, marked dirty; run() exchanges
+    // its read snapshot for a dirty one. Neither waits for the other.
+    ProgramSnapshot fPrograms[3];
+    uint32_t        fProgramWrite;
+    uint32_t        fProgramRead;
+    std::atomic<uint32_t> fProgramOverrides;  // parameters set since the program
+    std::atomic<uint32_t> fSessionApplied;    // serial of the settings run() applied
+    TruePeakMeter   fTruePeak[2];
+    LookaheadLimiter fLimiter;
+    DspLoadMeter    fLoadMeter;
+    MorphSnapshots  fMorph;
+    AbSlotSet       fAbSlots;
+    SessionSettings fSession;  // the latest, for the next program
+
+    // width << 16 | height of the editor, or 0 if unknown
+    std::atomic<uint32_t> fUiLayout;
+
+    void updateLoadParameters();
+
+    void updateParameter(uint32_t index, float value);
+    void applyParameter(uint32_t index, float value);
+    void updateMorph();
+    void prepareProgram(const float* values);
+    void publishProgram(const float* values);
+    void publishLiveProgram();
+    void stageSessionSettings(uint32_t fields, uint32_t crossfade, const float* meters);
+    void applySessionSettings(const SessionSettings& session);
+    void setSaturationEnabled(bool enabled);
+    void setLimiterEnabled(bool enabled);
+    void applyProgram(const ProgramSnapshot& program, uint32_t overrides);
+    void runCrossfade(float* outL, float* outR, uint32_t frames);
+    void updateLatency();
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginSimpleGain)
 };
 
-struct Preset {
-    const char* name;
-    float params[PluginSimpleGain::paramCount];
+/**
+  Parameters, in the order of PluginSimpleGain::Parameters.
+*/
+constexpr ParameterDescriptor kParameterDescriptors[] = {
+    // name, short name, symbol, unit, min, max, default, hints, taper
+    {"Gain (dB)", "Gain", "gain", "db",
+     -90.0f, 30.0f, 0.0f, kParameterIsAutomable, kTaperLinear},
+    {"Saturation", "Saturation", "saturation", "",
+     0.0f, 1.0f, 0.0f, kParameterIsAutomable | kParameterIsBoolean, kTaperToggle},
+    {"Limiter", "Limiter", "limiter", "",
+     0.0f, 1.0f, 0.0f, kParameterIsAutomable | kParameterIsBoolean, kTaperToggle},
+    {"Ceiling (dB)", "Ceiling", "ceiling", "db",
+     -20.0f, 0.0f, -1.0f, kParameterIsAutomable, kTaperLinear},
+    // position between the morph snapshots
+    {"Morph", "Morph", "morph", "",
+     0.0f, 1.0f, 0.0f, kParameterIsAutomable, kTaperLinear},
+    // the slot which the program parameters are from
+    {"A/B Slot", "A/B", "ab_slot", "",
+     0.0f, PluginSimpleGain::kAbSlots - 1.0f, 0.0f, kParameterIsAutomable | kParameterIsInteger, kTaperLinear},
+    {"True Peak Left (dBTP)", "TP Left", "true_peak_left", "dBTP",
+     -90.0f, 30.0f, -90.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
+    {"True Peak Right (dBTP)", "TP Right", "true_peak_right", "dBTP",
+     -90.0f, 30.0f, -90.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
+    // percent of the realtime budget of the block
+    {"DSP Load p50 (%)", "Load p50", "dsp_load_p50", "%",
+     0.0f, 1000.0f, 0.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
+    {"DSP Load p99 (%)", "Load p99", "dsp_load_p99", "%",
+     0.0f, 1000.0f, 0.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
+    {"DSP Load p99.9 (%)", "Load p99.9", "dsp_load_p999", "%",
+     0.0f, 1000.0f, 0.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
+    {"DSP Load Max (%)", "Load max", "dsp_load_max", "%",
+     0.0f, 1000.0f, 0.0f, kParameterIsAutomable | kParameterIsOutput, kTaperLinear},
 };
 
-const Preset factoryPresets[] = {
-    {
-        "Unity Gain",
-        {0.0f}
-    }
-    //,{
-    //    "Another preset",  // preset name
-    //    {-14.0f, ...}      // array of presetCount float param values
-    //}
-};
+static_assert(sizeof(kParameterDescriptors) / sizeof(kParameterDescriptors[0]) == PluginSimpleGain::paramCount,
+              "one descriptor per parameter");
 
-const uint presetCount = sizeof(factoryPresets) / sizeof(Preset);
+constexpr SymbolIndex<PluginSimpleGain::paramCount> kParameterSymbols(kParameterDescriptors);
 
 // -----------------------------------------------------------------------
 
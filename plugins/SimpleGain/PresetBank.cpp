@@ -0,0 +1,359 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "PresetBank.hpp"
+#include "ParameterTable.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+
+static const char kPresetBankMagic[8] = "SGPBANK";
+
+static uint32_t alignTo4(size_t size) {
+    return (uint32_t)((size + 3) & ~(size_t)3);
+}
+
+// the last generation given to an opened bank
+static std::atomic<uint64_t> gLastGeneration {0};
+
+// -----------------------------------------------------------------------
+
+bool PresetBank::open(const char* path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return fail("cannot open file");
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(PresetBankHeader) || size.QuadPart > 0xffffffff) {
+        CloseHandle(file);
+        return fail("cannot read file");
+    }
+    HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!section)
+        return fail("cannot map file");
+    fMapping = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (!fMapping)
+        return fail("cannot map file");
+    fMappingSize = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return fail("cannot open file");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PresetBankHeader) || st.st_size > (off_t)0xffffffff) {
+        ::close(fd);
+        return fail("cannot read file");
+    }
+
+    fMappingSize = (size_t)st.st_size;
+    fMapping = mmap(nullptr, fMappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (fMapping == MAP_FAILED) {
+        fMapping = nullptr;
+        return fail("cannot map file");
+    }
+#endif
+
+    fHeader = (const PresetBankHeader*)fMapping;
+    if (fHeader->fileSize != fMappingSize)
+        return fail("truncated file");
+    return validate();
+}
+
+bool PresetBank::open(std::vector<uint8_t>&& data) {
+    close();
+
+    fData = std::move(data);
+    if (fData.size() < sizeof(PresetBankHeader))
+        return fail("truncated bank");
+    fHeader = (const PresetBankHeader*)fData.data();
+    if (fHeader->fileSize != fData.size())
+        return fail("truncated bank");
+    return validate();
+}
+
+void PresetBank::close() {
+    if (fMapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(fMapping);
+#else
+        munmap(fMapping, fMappingSize);
+#endif
+        fMapping = nullptr;
+        fMappingSize = 0;
+    }
+    fData.clear();
+    fData.shrink_to_fit();
+    fGeneration = 0;
+    fHeader = nullptr;
+    fColumns = nullptr;
+    fRecords = nullptr;
+    fHash = nullptr;
+    fCategories = nullptr;
+    fStrings = nullptr;
+}
+
+bool PresetBank::fail(const char* message) {
+    fError = message;
+    close();
+    return false;
+}
+
+/**
+  Check every offset and index once, so that the lookups do not need to.
+*/
+bool PresetBank::validate() {
+    const PresetBankHeader& header = *fHeader;
+    const uint8_t* const base = (const uint8_t*)fHeader;
+    const uint64_t size = header.fileSize;
+
+    if (std::memcmp(header.magic, kPresetBankMagic, sizeof(header.magic)) != 0)
+        return fail("not a preset bank");
+    if (header.byteOrder != kPresetBankByteOrder)
+        return fail("bank written in another byte order");
+    if (header.version != kPresetBankVersion)
+        return fail("unsupported bank version");
+
+    const auto inside = [size](uint32_t offset, uint64_t length) {
+        return (offset & 3) == 0 && offset <= size && length <= size - offset;
+    };
+
+    const uint64_t presets = header.presetCount;
+    if (header.recordSize != sizeof(PresetBankRecord) + 4 * (uint64_t)header.columnCount ||
+        !inside(header.columnsOffset, 4 * (uint64_t)header.columnCount) ||
+        !inside(header.recordsOffset, presets * header.recordSize) ||
+        !inside(header.categoriesOffset, 4 * presets) ||
+        !inside(header.hashOffset, 4 * (uint64_t)header.hashSize) ||
+        !inside(header.stringsOffset, header.stringsSize))
+        return fail("invalid section");
+    if (header.hashSize < presets || header.hashSize == 0 || (header.hashSize & (header.hashSize - 1)) != 0)
+        return fail("invalid hash size");
+    if (header.stringsSize == 0 || base[header.stringsOffset + header.stringsSize - 1] != '\0')
+        return fail("invalid strings");
+
+    fColumns = (const uint32_t*)(base + header.columnsOffset);
+    fRecords = base + header.recordsOffset;
+    fHash = (const uint32_t*)(base + header.hashOffset);
+    fCategories = (const uint32_t*)(base + header.categoriesOffset);
+    fStrings = (const char*)(base + header.stringsOffset);
+
+    for (uint32_t c = 0; c < header.columnCount; ++c) {
+        if (fColumns[c] >= header.stringsSize)
+            return fail("invalid column");
+    }
+    for (uint32_t i = 0; i < header.presetCount; ++i) {
+        const PresetBankRecord* record = getRecord(i);
+        if (record->name >= header.stringsSize || record->category >= header.stringsSize)
+            return fail("invalid preset");
+        if (fCategories[i] >= header.presetCount)
+            return fail("invalid category index");
+    }
+    // a probe ends at an empty slot, so there must be one
+    uint32_t filled = 0;
+    for (uint32_t s = 0; s < header.hashSize; ++s) {
+        if (fHash[s] > header.presetCount)
+            return fail("invalid hash index");
+        filled += fHash[s] != 0;
+    }
+    if (filled >= header.hashSize)
+        return fail("hash table without an empty slot");
+
+    fGeneration = gLastGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    fError.clear();
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+int PresetBank::findPreset(const char* name) const {
+    if (!fHeader)
+        return -1;
+
+    const uint32_t mask = fHeader->hashSize - 1;
+    for (uint32_t s = symbolHash(name, 0) & mask;; s = (s + 1) & mask) {
+        const uint32_t entry = fHash[s];
+        if (entry == 0)
+            return -1;
+        if (std::strcmp(getPresetName(entry - 1), name) == 0)
+            return (int)(entry - 1);
+    }
+}
+
+void PresetBank::findCategory(const char* category, uint32_t& first, uint32_t& end) const {
+    const uint32_t* const begin = fCategories;
+    const uint32_t* const last = fCategories + getPresetCount();
+    const uint32_t* const from = std::lower_bound(begin, last, category,
+        [this](uint32_t index, const char* key) {
+            return std::strcmp(getPresetCategory(index), key) < 0;
+        });
+    const uint32_t* const to = std::upper_bound(from, last, category,
+        [this](const char* key, uint32_t index) {
+            return std::strcmp(key, getPresetCategory(index)) < 0;
+        });
+    first = (uint32_t)(from - begin);
+    end = (uint32_t)(to - begin);
+}
+
+// -----------------------------------------------------------------------
+
+PresetBankBuilder::PresetBankBuilder(const std::vector<std::string>& columnSymbols)
+    : fColumns(columnSymbols)
+{
+}
+
+bool PresetBankBuilder::add(const std::string& name, const std::string& category, const float* values) {
+    if (!fNames.insert(name).second)
+        return false;
+    fPresets.push_back({name, category, std::vector<float>(values, values + fColumns.size())});
+    return true;
+}
+
+std::vector<uint8_t> PresetBankBuilder::build() const {
+    const uint32_t presetCount = (uint32_t)fPresets.size();
+    const uint32_t columnCount = (uint32_t)fColumns.size();
+
+    // at most half full, for short probes
+    uint32_t hashSize = 1;
+    while (hashSize < 2 * presetCount)
+        hashSize *= 2;
+
+    // strings, each stored once
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> stringOffsets;
+    const auto addString = [&](const std::string& text) {
+        const auto it = stringOffsets.find(text);
+        if (it != stringOffsets.end())
+            return it->second;
+        const uint32_t offset = (uint32_t)strings.size();
+        strings.append(text.c_str(), text.size() + 1);
+        stringOffsets.emplace(text, offset);
+        return offset;
+    };
+
+    PresetBankHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kPresetBankMagic, sizeof(header.magic));
+    header.version = kPresetBankVersion;
+    header.byteOrder = kPresetBankByteOrder;
+    header.presetCount = presetCount;
+    header.columnCount = columnCount;
+    header.recordSize = sizeof(PresetBankRecord) + 4 * columnCount;
+    header.columnsOffset = alignTo4(sizeof(header));
+    header.recordsOffset = header.columnsOffset + 4 * columnCount;
+    header.hashOffset = header.recordsOffset + presetCount * header.recordSize;
+    header.hashSize = hashSize;
+    header.categoriesOffset = header.hashOffset + 4 * hashSize;
+    header.stringsOffset = header.categoriesOffset + 4 * presetCount;
+
+    std::vector<uint32_t> columns(columnCount);
+    for (uint32_t c = 0; c < columnCount; ++c)
+        columns[c] = addString(fColumns[c]);
+
+    std::vector<uint8_t> records((size_t)presetCount * header.recordSize);
+    std::vector<uint32_t> hash(hashSize, 0);
+    for (uint32_t i = 0; i < presetCount; ++i) {
+        const Preset& preset = fPresets[i];
+        PresetBankRecord record;
+        record.name = addString(preset.name);
+        record.category = addString(preset.category);
+        uint8_t* const bytes = records.data() + (size_t)i * header.recordSize;
+        std::memcpy(bytes, &record, sizeof(record));
+        std::memcpy(bytes + sizeof(record), preset.values.data(), 4 * columnCount);
+
+        uint32_t s = symbolHash(preset.name.c_str(), 0) & (hashSize - 1);
+        while (hash[s] != 0)
+            s = (s + 1) & (hashSize - 1);
+        hash[s] = i + 1;
+    }
+
+    std::vector<uint32_t> categories(presetCount);
+    for (uint32_t i = 0; i < presetCount; ++i)
+        categories[i] = i;
+    std::sort(categories.begin(), categories.end(), [this](uint32_t a, uint32_t b) {
+        const int order = std::strcmp(fPresets[a].category.c_str(), fPresets[b].category.c_str());
+        return (order != 0) ? (order < 0) : (fPresets[a].name < fPresets[b].name);
+    });
+
+    header.stringsSize = (uint32_t)strings.size();
+    header.fileSize = alignTo4(header.stringsOffset + strings.size());
+
+    std::vector<uint8_t> data(header.fileSize, 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + header.columnsOffset, columns.data(), 4 * columnCount);
+    std::memcpy(data.data() + header.recordsOffset, records.data(), records.size());
+    std::memcpy(data.data() + header.hashOffset, hash.data(), 4 * hashSize);
+    std::memcpy(data.data() + header.categoriesOffset, categories.data(), 4 * presetCount);
+    std::memcpy(data.data() + header.stringsOffset, strings.data(), strings.size());
+    return data;
+}
+
+// rename over an existing file, which rename() does not do on Windows
+static bool replaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from, to) == 0;
+#endif
+}
+
+/**
+  The bank is written beside the path and renamed over it: a bank which a
+  process has mapped keeps its file, where rewriting it in place would
+  truncate the mapping under the readers. On Windows, the rename is
+  MoveFileEx() with MOVEFILE_REPLACE_EXISTING; it fails while another
+  process maps the old bank, which then stays as it was.
+*/
+bool PresetBankBuilder::write(const char* path) const {
+    const std::vector<uint8_t> data = build();
+    const std::string temporary = std::string(path) + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (std::fclose(file) != 0 || !written || !replaceFile(temporary.c_str(), path)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
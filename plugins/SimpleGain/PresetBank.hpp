@@ -0,0 +1,192 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PRESET_BANK_H
+#define PRESET_BANK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Binary bank of presets, read in place from a memory-mapped file.
+
+  The file is a PresetBankHeader, then the following sections, each at an
+  offset given by the header and aligned to 4 bytes:
+
+  - columns: one string offset per parameter stored in a preset, to the
+    symbol of that parameter
+  - records: one PresetBankRecord per preset, each followed by the values
+    of its columns as floats
+  - hash: hashSize slots, a power of two, holding a preset index plus one
+    or 0 when empty; a name is looked up with symbolHash(name, 0) from
+    ParameterTable.hpp, then linear probing
+  - categories: the preset indices sorted by category, then by name
+  - strings: NUL-terminated names, categories and symbols
+
+  All numbers are in the byte order of the machine which wrote the file.
+  A reader rejects a file of another byte order or of another version.
+*/
+
+struct PresetBankHeader {
+    char magic[8];              // "SGPBANK"
+    uint32_t version;
+    uint32_t byteOrder;         // kPresetBankByteOrder, as written
+    uint32_t fileSize;
+    uint32_t presetCount;
+    uint32_t columnCount;
+    uint32_t recordSize;        // bytes per record, with its values
+    uint32_t columnsOffset;
+    uint32_t recordsOffset;
+    uint32_t hashOffset;
+    uint32_t hashSize;
+    uint32_t categoriesOffset;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t reserved;
+};
+
+struct PresetBankRecord {
+    uint32_t name;              // string offsets
+    uint32_t category;
+    // followed by columnCount float values
+};
+
+static const uint32_t kPresetBankVersion = 1;
+static const uint32_t kPresetBankByteOrder = 0x01020304;
+
+/**
+  Read-only view of a bank, mapped from a file or held in memory.
+
+  Once opened, a bank is never modified, so any number of instances and
+  threads may read it at the same time. Finding a preset by index or by
+  name neither copies nor allocates.
+*/
+class PresetBank {
+public:
+    PresetBank() {}
+    ~PresetBank() { close(); }
+
+    bool open(const char* path);
+    // take the bytes of a bank made by PresetBankBuilder
+    bool open(std::vector<uint8_t>&& data);
+    void close();
+
+    const std::string& getError() const { return fError; }
+
+    /**
+      A number which no other opening of a bank in the process has had, to
+      tell this bank from one opened at the same address; 0 when closed.
+    */
+    uint64_t getGeneration() const { return fGeneration; }
+
+    uint32_t getPresetCount() const { return fHeader ? fHeader->presetCount : 0; }
+    uint32_t getColumnCount() const { return fHeader ? fHeader->columnCount : 0; }
+    const char* getColumnSymbol(uint32_t column) const { return getString(fColumns[column]); }
+
+    const char* getPresetName(uint32_t index) const { return getString(getRecord(index)->name); }
+    const char* getPresetCategory(uint32_t index) const { return getString(getRecord(index)->category); }
+
+    // the values of the columns, in place in the bank
+    const float* getPresetValues(uint32_t index) const {
+        return (const float*)(getRecord(index) + 1);
+    }
+
+    /**
+      Index of the preset with this name, or -1.
+    */
+    int findPreset(const char* name) const;
+
+    /**
+      Range [first, end) of the category order where the presets of this
+      category are; empty if there is none.
+    */
+    void findCategory(const char* category, uint32_t& first, uint32_t& end) const;
+
+    // the preset at a rank of the order by category, then name
+    uint32_t getSortedPreset(uint32_t rank) const { return fCategories[rank]; }
+
+private:
+    bool validate();
+    bool fail(const char* message);
+
+    const PresetBankRecord* getRecord(uint32_t index) const {
+        return (const PresetBankRecord*)(fRecords + (size_t)index * fHeader->recordSize);
+    }
+    const char* getString(uint32_t offset) const { return fStrings + offset; }
+
+    std::string fError;
+    uint64_t fGeneration = 0;
+    const PresetBankHeader* fHeader = nullptr;
+    const uint32_t* fColumns = nullptr;
+    const uint8_t* fRecords = nullptr;
+    const uint32_t* fHash = nullptr;
+    const uint32_t* fCategories = nullptr;
+    const char* fStrings = nullptr;
+
+    // storage, either a mapping or a buffer
+    void* fMapping = nullptr;
+    size_t fMappingSize = 0;
+    std::vector<uint8_t> fData;
+
+    PresetBank(const PresetBank&) = delete;
+    PresetBank& operator=(const PresetBank&) = delete;
+};
+
+/**
+  Makes the bytes of a bank, from presets given in any order.
+*/
+class PresetBankBuilder {
+public:
+    explicit PresetBankBuilder(const std::vector<std::string>& columnSymbols);
+
+    // false if there is already a preset of that name
+    bool add(const std::string& name, const std::string& category, const float* values);
+
+    size_t getPresetCount() const { return fPresets.size(); }
+
+    std::vector<uint8_t> build() const;
+    bool write(const char* path) const;
+
+private:
+    struct Preset {
+        std::string name;
+        std::string category;
+        std::vector<float> values;
+    };
+
+    std::vector<std::string> fColumns;
+    std::vector<Preset> fPresets;
+    std::unordered_set<std::string> fNames;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef PRESET_BANK_H
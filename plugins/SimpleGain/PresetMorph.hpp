@@ -0,0 +1,98 @@
+/**
+ * Morph between parameter snapshots
+ *
+ * A snapshot is the values of a set of parameters. The morph position goes
+ * from the first snapshot at 0 to the last at 1, through the others at
+ * equal steps, and the values in between are interpolated linearly from
+ * the two nearest snapshots. They are to be given in the domain where a
+ * linear change is heard as even, dB for a gain; a toggle switches halfway
+ * between two snapshots, where its value crosses the middle.
+ *
+ * The snapshots are the rows of one array, padded to whole SSE vectors, so
+ * that a morph is one pass of a few vector operations over two rows. It
+ * allocates nothing, and costs the same whatever the position.
+ */
+
+#ifndef PRESET_MORPH_H
+#define PRESET_MORPH_H
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define PRESET_MORPH_USE_SSE 1
+#endif
+
+template <uint32_t Columns, uint32_t MaxSnapshots>
+class PresetMorph {
+public:
+    static_assert(MaxSnapshots >= 2, "a morph goes between two snapshots at least");
+
+    enum {
+        kColumns = Columns,
+        kMaxSnapshots = MaxSnapshots,
+        kStride = (Columns + 3) & ~3u,  // floats per row, and of a result
+    };
+
+    PresetMorph() { clear(); }
+
+    void clear() {
+        fCount = 0;
+        for (uint32_t s = 0; s < kMaxSnapshots; ++s)
+            for (uint32_t c = 0; c < kStride; ++c)
+                fRows[s][c] = 0.0f;
+    }
+
+    uint32_t getSnapshotCount() const { return fCount; }
+
+    // there is nothing to morph between with fewer than two
+    bool isActive() const { return fCount >= 2; }
+
+    const float* getSnapshot(uint32_t index) const { return fRows[index]; }
+
+    /**
+      Set the kColumns values of a snapshot; the snapshots before it, which
+      were not set, are zero.
+    */
+    void setSnapshot(uint32_t index, const float* values) {
+        if (index >= kMaxSnapshots)
+            return;
+        for (uint32_t c = 0; c < kColumns; ++c)
+            fRows[index][c] = values[c];
+        if (fCount <= index)
+            fCount = index + 1;
+    }
+
+    /**
+      The kStride values at a position from 0 to 1, into a result aligned
+      on 16 bytes. Needs two snapshots.
+    */
+    void interpolate(float position, float* result) const {
+        position = (position > 0.0f) ? ((position < 1.0f) ? position : 1.0f) : 0.0f;
+        const float x = position * (float)(fCount - 1);
+        uint32_t first = (uint32_t)x;
+        if (first > fCount - 2)
+            first = fCount - 2;
+        const float t = x - (float)first;
+
+        const float* const a = fRows[first];
+        const float* const b = fRows[first + 1];
+#if defined(PRESET_MORPH_USE_SSE)
+        const __m128 vt = _mm_set1_ps(t);
+        for (uint32_t c = 0; c < kStride; c += 4) {
+            const __m128 va = _mm_load_ps(a + c);
+            const __m128 vb = _mm_load_ps(b + c);
+            _mm_store_ps(result + c, _mm_add_ps(va, _mm_mul_ps(vt, _mm_sub_ps(vb, va))));
+        }
+#else
+        for (uint32_t c = 0; c < kStride; ++c)
+            result[c] = a[c] + t * (b[c] - a[c]);
+#endif
+    }
+
+private:
+    alignas(16) float fRows[kMaxSnapshots][kStride];
+    uint32_t fCount;
+};
+
+#endif  // #ifndef PRESET_MORPH_H
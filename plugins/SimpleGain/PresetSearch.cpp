@@ -0,0 +1,216 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "PresetSearch.hpp"
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define PRESET_SEARCH_USE_SSE 1
+#endif
+
+// -----------------------------------------------------------------------
+
+static char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+uint32_t PresetSearch::trigramBucket(const char* s) {
+    const uint32_t key = (uint8_t)s[0] | ((uint32_t)(uint8_t)s[1] << 8) | ((uint32_t)(uint8_t)s[2] << 16);
+    return (key * 2654435761u) >> (32 - kBucketBits);
+}
+
+void PresetSearch::build(const PresetBank& bank) {
+    fBank = &bank;
+    fGeneration = bank.getGeneration();
+    const uint32_t count = bank.getPresetCount();
+
+    fNames.clear();
+    fNameOffsets.clear();
+    fNameOffsets.reserve(count + 1);
+    for (uint32_t rank = 0; rank < count; ++rank) {
+        fNameOffsets.push_back((uint32_t)fNames.size());
+        for (const char* c = bank.getPresetName(bank.getSortedPreset(rank)); *c; ++c)
+            fNames.push_back(toLowerAscii(*c));
+        fNames.push_back('\0');
+    }
+    fNameOffsets.push_back((uint32_t)fNames.size());
+
+    // count the ranks of each bucket, then fill them in order; a name is
+    // listed once in a bucket, however many of its trigrams fall there
+    std::vector<uint32_t> last(kBuckets, UINT32_MAX);
+    fBucketStarts.assign(kBuckets + 1, 0);
+    for (uint32_t rank = 0; rank < count; ++rank) {
+        for (uint32_t i = fNameOffsets[rank]; i + 3 < fNameOffsets[rank + 1]; ++i) {
+            const uint32_t bucket = trigramBucket(&fNames[i]);
+            if (last[bucket] != rank) {
+                last[bucket] = rank;
+                ++fBucketStarts[bucket + 1];
+            }
+        }
+    }
+    for (uint32_t bucket = 0; bucket < kBuckets; ++bucket)
+        fBucketStarts[bucket + 1] += fBucketStarts[bucket];
+
+    std::vector<uint32_t> fill(fBucketStarts.begin(), fBucketStarts.end() - 1);
+    fPostings.resize(fBucketStarts[kBuckets]);
+    last.assign(kBuckets, UINT32_MAX);
+    for (uint32_t rank = 0; rank < count; ++rank) {
+        for (uint32_t i = fNameOffsets[rank]; i + 3 < fNameOffsets[rank + 1]; ++i) {
+            const uint32_t bucket = trigramBucket(&fNames[i]);
+            if (last[bucket] != rank) {
+                last[bucket] = rank;
+                fPostings[fill[bucket]++] = rank;
+            }
+        }
+    }
+
+    fHistory.clear();
+    fSearched = false;
+    search("");
+}
+
+bool PresetSearch::matches(uint32_t rank, const std::string& query) const {
+    const std::string_view name(fNames.data() + fNameOffsets[rank], fNameOffsets[rank + 1] - 1 - fNameOffsets[rank]);
+    return name.find(query) != std::string_view::npos;
+}
+
+void PresetSearch::search(const char* query) {
+    std::string lowered;
+    for (const char* c = query; *c; ++c)
+        lowered.push_back(toLowerAscii(*c));
+    if (fSearched && lowered == fQuery)
+        return;
+
+    // the results of a query are among those of any part of it
+    const bool narrows = fSearched && !fQuery.empty() && lowered.find(fQuery) != std::string::npos;
+
+    // the queries typed on the way are kept, for an erase to go back to
+    if (narrows) {
+        fHistory.emplace_back(fQuery, fRanks);
+    } else {
+        while (!fHistory.empty() && fHistory.back().first.size() > lowered.size())
+            fHistory.pop_back();
+        if (!fHistory.empty() && fHistory.back().first == lowered) {
+            fRanks.swap(fHistory.back().second);
+            fHistory.pop_back();
+            fQuery = lowered;
+            return;
+        }
+        fHistory.clear();
+    }
+
+    if (lowered.empty()) {
+        fRanks.resize(getPresetCount());
+        for (uint32_t rank = 0; rank < fRanks.size(); ++rank)
+            fRanks[rank] = rank;
+    } else if (narrows && fRanks.size() <= kNarrowMax) {
+        fRanks.erase(std::remove_if(fRanks.begin(), fRanks.end(),
+                                    [&](uint32_t rank) { return !matches(rank, lowered); }),
+                     fRanks.end());
+    } else if (lowered.size() >= 3) {
+        searchTrigrams(lowered);
+    } else {
+        searchShort(lowered);
+    }
+
+    fQuery = lowered;
+    fSearched = true;
+}
+
+/**
+  A query of one or two characters, compared with every position of the
+  buffer of names, 16 at a time; a match is mapped to its name, and the
+  rest of that name is skipped.
+*/
+void PresetSearch::searchShort(const std::string& query) {
+    fRanks.clear();
+    const char* const names = fNames.data();
+    const uint32_t size = (uint32_t)fNames.size();
+    const char first = query[0];
+    const char second = query[1];  // the terminator of a single character
+    const bool two = query.size() > 1;
+
+    uint32_t rank = 0;
+    uint32_t skipUntil = 0;
+    const auto match = [&](uint32_t pos) {
+        if (pos < skipUntil)
+            return;
+        while (fNameOffsets[rank + 1] <= pos)
+            ++rank;
+        fRanks.push_back(rank);
+        skipUntil = fNameOffsets[rank + 1];
+    };
+
+    uint32_t pos = 0;
+#if defined(PRESET_SEARCH_USE_SSE)
+    const __m128i firsts = _mm_set1_epi8(first);
+    const __m128i seconds = _mm_set1_epi8(second);
+    for (; pos + 17 <= size; pos += 16) {
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(names + pos)), firsts));
+        if (mask && two)
+            mask &= (uint32_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(names + pos + 1)), seconds));
+        for (; mask; mask &= mask - 1)
+            match(pos + (uint32_t)__builtin_ctz(mask));
+    }
+#endif
+    // a match never reaches the end, which is a terminator
+    for (; pos + 1 < size; ++pos) {
+        if (names[pos] == first && (!two || names[pos + 1] == second))
+            match(pos);
+    }
+}
+
+void PresetSearch::searchTrigrams(const std::string& query) {
+    std::vector<uint32_t> buckets;
+    for (size_t i = 0; i + 3 <= query.size(); ++i)
+        buckets.push_back(trigramBucket(&query[i]));
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+    const auto size = [this](uint32_t bucket) { return fBucketStarts[bucket + 1] - fBucketStarts[bucket]; };
+    std::sort(buckets.begin(), buckets.end(), [&](uint32_t a, uint32_t b) { return size(a) < size(b); });
+
+    const uint32_t* const postings = fPostings.data();
+    fRanks.assign(postings + fBucketStarts[buckets[0]], postings + fBucketStarts[buckets[0] + 1]);
+    for (size_t b = 1; b < buckets.size() && fRanks.size() > kFewCandidates; ++b) {
+        fScratch.clear();
+        std::set_intersection(fRanks.begin(), fRanks.end(),
+                              postings + fBucketStarts[buckets[b]], postings + fBucketStarts[buckets[b] + 1],
+                              std::back_inserter(fScratch));
+        fRanks.swap(fScratch);
+    }
+
+    // the buckets hold other trigrams of the same hash, and the trigrams
+    // of a name may be in another order
+    fRanks.erase(std::remove_if(fRanks.begin(), fRanks.end(),
+                                [&](uint32_t rank) { return !matches(rank, query); }),
+                 fRanks.end());
+}
@@ -0,0 +1,120 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PRESET_SEARCH_H
+#define PRESET_SEARCH_H
+
+#include "PresetBank.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Search of the presets of a bank by name, for a browser which filters as
+  the user types.
+
+  A query matches the names which contain it, ignoring ASCII case. The
+  names are kept lowercase in one buffer, and indexed by trigram: each of
+  65536 buckets lists, in order, the presets with a trigram of that hash.
+  A query of three characters or more is looked up in the buckets of its
+  own trigrams, whose lists are intersected, shortest first, until few
+  candidates are left; the candidates are then checked against the whole
+  query. A shorter query is searched in the buffer directly.
+
+  The search is incremental: a query which contains the last one is only
+  checked against the last results, as when a character is typed, and the
+  results of the queries typed on the way are kept until the query goes
+  elsewhere, as when characters are erased.
+
+  The results are presets in the order of the bank by category, then
+  name. Building the index takes a few milliseconds for 100k presets, and
+  a search well under one.
+*/
+class PresetSearch {
+public:
+    /**
+      Index the names of a bank, which must outlive the index or be
+      indexed again.
+    */
+    void build(const PresetBank& bank);
+
+    // whether this bank is the one indexed, and not another opened since
+    // at the same address
+    bool isBuiltFor(const PresetBank& bank) const {
+        return &bank == fBank && bank.getGeneration() == fGeneration;
+    }
+
+    uint32_t getPresetCount() const { return (uint32_t)(fNameOffsets.empty() ? 0 : fNameOffsets.size() - 1); }
+
+    /**
+      Filter the presets with a query; empty matches all.
+    */
+    void search(const char* query);
+
+    const std::string& getQuery() const { return fQuery; }
+
+    // the presets found, in the order of the bank by category then name
+    uint32_t getResultCount() const { return (uint32_t)fRanks.size(); }
+    uint32_t getResult(uint32_t i) const { return fBank->getSortedPreset(fRanks[i]); }
+
+private:
+    enum {
+        kBucketBits = 16,
+        kBuckets = 1 << kBucketBits,
+        kFewCandidates = 64,  // left to check rather than intersect further
+        kNarrowMax = 4096,    // last results to check rather than look up
+    };
+
+    static uint32_t trigramBucket(const char* s);
+
+    bool matches(uint32_t rank, const std::string& query) const;
+    void searchShort(const std::string& query);
+    void searchTrigrams(const std::string& query);
+
+    const PresetBank* fBank = nullptr;
+    uint64_t fGeneration = 0;  // of the bank indexed
+
+    // the lowercase names in the order of the bank, separated by '\0'
+    std::string fNames;
+    std::vector<uint32_t> fNameOffsets;  // one per rank, and the end
+
+    // ranks of each bucket, at fPostings[fBucketStarts[b]] to fBucketStarts[b + 1]
+    std::vector<uint32_t> fBucketStarts;
+    std::vector<uint32_t> fPostings;
+
+    bool fSearched = false;
+    std::string fQuery;
+    std::vector<uint32_t> fRanks;  // of the results
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> fHistory;
+    std::vector<uint32_t> fScratch;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef PRESET_SEARCH_H
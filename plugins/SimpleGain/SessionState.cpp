@@ -0,0 +1,252 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "SessionState.hpp"
+#include <cstring>
+
+// -----------------------------------------------------------------------
+
+static const uint8_t kSessionStateMagic[4] = {'S', 'G', 'S', 'T'};
+
+// the reflected CRC-32 of zlib and PNG, a byte at a time
+struct Crc32Table {
+    uint32_t entries[256];
+
+    constexpr Crc32Table() : entries() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (unsigned bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320u : 0u);
+            entries[i] = crc;
+        }
+    }
+};
+
+static constexpr Crc32Table kCrc32Table;
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; ++i)
+        crc = kCrc32Table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+static size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+static uint8_t* putVarint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+// -----------------------------------------------------------------------
+// Writing
+
+StateWriter::StateWriter() {
+    fData.reserve(256);
+    fData.insert(fData.end(), kSessionStateMagic, kSessionStateMagic + sizeof(kSessionStateMagic));
+    writeVarint(kSessionStateVersion);
+}
+
+void StateWriter::beginField(uint32_t tag) {
+    writeVarint(tag);
+    fFieldStarts[fDepth++] = fData.size();
+}
+
+/**
+  The length of the contents is only known now; it is moved in before them.
+*/
+void StateWriter::endField() {
+    const size_t start = fFieldStarts[--fDepth];
+    const size_t length = fData.size() - start;
+    uint8_t prefix[10];
+    const size_t prefixSize = (size_t)(putVarint(prefix, length) - prefix);
+    fData.insert(fData.begin() + start, prefix, prefix + prefixSize);
+}
+
+void StateWriter::writeVarint(uint64_t value) {
+    const size_t size = fData.size();
+    fData.resize(size + varintSize(value));
+    putVarint(fData.data() + size, value);
+}
+
+void StateWriter::writeFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint8_t bytes[4] = {(uint8_t)bits, (uint8_t)(bits >> 8), (uint8_t)(bits >> 16), (uint8_t)(bits >> 24)};
+    fData.insert(fData.end(), bytes, bytes + 4);
+}
+
+void StateWriter::writeBytes(const void* data, size_t size) {
+    fData.insert(fData.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+const std::vector<uint8_t>& StateWriter::finish() {
+    const uint32_t crc = crc32(fData.data(), fData.size());
+    const uint8_t bytes[4] = {(uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+    fData.insert(fData.end(), bytes, bytes + 4);
+    return fData;
+}
+
+// -----------------------------------------------------------------------
+// Reading
+
+bool StateReader::open(const uint8_t* data, size_t size) {
+    fData = fEnd = data;
+    if (size < sizeof(kSessionStateMagic) + 1 + 4 ||
+        std::memcmp(data, kSessionStateMagic, sizeof(kSessionStateMagic)) != 0)
+        return false;
+
+    const uint8_t* const check = data + size - 4;
+    const uint32_t crc = (uint32_t)check[0] | ((uint32_t)check[1] << 8) |
+                         ((uint32_t)check[2] << 16) | ((uint32_t)check[3] << 24);
+    if (crc != crc32(data, size - 4))
+        return false;
+
+    fData = data + sizeof(kSessionStateMagic);
+    fEnd = check;
+    return readVarint(fVersion) && fVersion == kSessionStateVersion;
+}
+
+bool StateReader::nextField(uint32_t& tag, StateReader& contents) {
+    uint64_t length;
+    if (!readVarint(tag) || !readVarint(length) || length > getSize())
+        return fail();
+    contents = StateReader(fData, (size_t)length);
+    fData += length;
+    return true;
+}
+
+bool StateReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && fData != fEnd; shift += 7) {
+        const uint8_t byte = *fData++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return fail();
+}
+
+bool StateReader::readVarint(uint32_t& value) {
+    uint64_t wide;
+    if (!readVarint(wide) || wide > 0xffffffffu)
+        return fail();
+    value = (uint32_t)wide;
+    return true;
+}
+
+bool StateReader::readFloat(float& value) {
+    if (getSize() < 4)
+        return fail();
+    const uint32_t bits = (uint32_t)fData[0] | ((uint32_t)fData[1] << 8) |
+                          ((uint32_t)fData[2] << 16) | ((uint32_t)fData[3] << 24);
+    std::memcpy(&value, &bits, sizeof(value));
+    fData += 4;
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// Base64, RFC 4648 with padding
+
+static const char kBase64Digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string encodeBase64(const uint8_t* data, size_t size) {
+    std::string text((size + 2) / 3 * 4, '=');
+    char* out = &text[0];
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        const uint32_t group = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        *out++ = kBase64Digits[group >> 18];
+        *out++ = kBase64Digits[(group >> 12) & 63];
+        *out++ = kBase64Digits[(group >> 6) & 63];
+        *out++ = kBase64Digits[group & 63];
+    }
+    if (i < size) {
+        const uint32_t group = ((uint32_t)data[i] << 16) | ((i + 1 < size) ? (uint32_t)data[i + 1] << 8 : 0);
+        out[0] = kBase64Digits[group >> 18];
+        out[1] = kBase64Digits[(group >> 12) & 63];
+        if (i + 1 < size)
+            out[2] = kBase64Digits[(group >> 6) & 63];
+    }
+    return text;
+}
+
+struct Base64Table {
+    int8_t values[256];
+
+    constexpr Base64Table() : values() {
+        for (unsigned c = 0; c < 256; ++c)
+            values[c] = -1;
+        for (unsigned v = 0; v < 64; ++v)
+            values[(uint8_t)kBase64Digits[v]] = (int8_t)v;
+    }
+};
+
+static constexpr Base64Table kBase64Table;
+
+bool decodeBase64(const char* text, uint8_t* data, size_t capacity, size_t& size) {
+    size = 0;
+
+    uint32_t group = 0;
+    unsigned bits = 0;
+    for (const char* c = text; *c != '\0'; ++c) {
+        if (*c == '=')
+            break;
+        const int8_t value = kBase64Table.values[(uint8_t)*c];
+        if (value < 0)
+            return false;
+        group = (group << 6) | (uint32_t)value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (size == capacity)
+                return false;
+            data[size++] = (uint8_t)(group >> bits);
+        }
+    }
+    return true;
+}
+
+bool decodeBase64(const char* text, std::vector<uint8_t>& data) {
+    // 6 bits per character
+    data.resize(std::strlen(text) / 4 * 3 + 2);
+    size_t size;
+    const bool valid = decodeBase64(text, data.data(), data.size(), size);
+    data.resize(size);
+    return valid;
+}
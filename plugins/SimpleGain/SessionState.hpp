@@ -0,0 +1,127 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SESSION_STATE_H
+#define SESSION_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Compact binary encoding of the state of an instance in a session.
+
+  A state is the magic "SGST", the format version as a varint, a sequence
+  of fields, then the CRC-32 of all that, in 4 bytes little-endian. A field
+  is its tag and the length of its contents, both varints, then the
+  contents; a reader skips the tags it does not know, so fields may be
+  added without a new version. Integers are LEB128 varints, and floats are
+  4 bytes little-endian.
+
+  Hosts keep plugin states as text, so a state travels in base64.
+*/
+
+static const uint32_t kSessionStateVersion = 1;
+
+/**
+  Writes a state, field by field; fields may nest.
+*/
+class StateWriter {
+public:
+    StateWriter();
+
+    void beginField(uint32_t tag);
+    void endField();
+
+    void writeVarint(uint64_t value);
+    void writeFloat(float value);
+    void writeBytes(const void* data, size_t size);
+
+    // append the checksum, and return the whole state
+    const std::vector<uint8_t>& finish();
+
+private:
+    enum { kMaxDepth = 8 };
+
+    std::vector<uint8_t> fData;
+    size_t fFieldStarts[kMaxDepth];
+    uint32_t fDepth = 0;
+};
+
+/**
+  Reads the fields of a state, or the contents of a field. A failed read
+  leaves the reader at its end, so a truncated field reads as invalid
+  rather than past its end.
+*/
+class StateReader {
+public:
+    StateReader() {}
+    StateReader(const uint8_t* data, size_t size) : fData(data), fEnd(data + size) {}
+
+    /**
+      Check the magic, the version and the checksum of a whole state, and
+      read its fields.
+    */
+    bool open(const uint8_t* data, size_t size);
+
+    uint32_t getVersion() const { return fVersion; }
+    bool atEnd() const { return fData == fEnd; }
+
+    bool nextField(uint32_t& tag, StateReader& contents);
+
+    bool readVarint(uint64_t& value);
+    bool readVarint(uint32_t& value);
+    bool readFloat(float& value);
+
+    // the rest of the reader, as it is
+    const uint8_t* getData() const { return fData; }
+    size_t getSize() const { return (size_t)(fEnd - fData); }
+
+private:
+    bool fail() {
+        fData = fEnd;
+        return false;
+    }
+
+    const uint8_t* fData = nullptr;
+    const uint8_t* fEnd = nullptr;
+    uint32_t fVersion = 0;
+};
+
+uint32_t crc32(const uint8_t* data, size_t size);
+
+std::string encodeBase64(const uint8_t* data, size_t size);
+bool decodeBase64(const char* text, std::vector<uint8_t>& data);
+
+// Into a buffer, without allocating; false as well if it is too small
+bool decodeBase64(const char* text, uint8_t* data, size_t capacity, size_t& size);
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef SESSION_STATE_H
@@ -0,0 +1,300 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "SimpleGainPanel.hpp"
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+SimpleGainPanel::SimpleGainPanel(Listener* listener)
+    : fListener(listener)
+{
+    for (uint32_t index = 0; index < PluginSimpleGain::paramCount; ++index)
+        params[index] = kParameterDescriptors[index].def;
+}
+
+void SimpleGainPanel::draw(float width, float height) {
+    float margin = 20.0f;
+
+    ImGui::SetNextWindowPos(ImVec2(margin, margin));
+    ImGui::SetNextWindowSize(ImVec2(width - 2 * margin, height - 2 * margin));
+
+    if (ImGui::Begin("Simple gain")) {
+        static char aboutText[256] =
+            "This is a demo plugin made with ImGui.\n";
+        ImGui::InputTextMultiline("About", aboutText, sizeof(aboutText));
+
+        drawAbSlots();
+
+        for (uint32_t index = 0; index < PluginSimpleGain::paramCount; ++index)
+        {
+            if (PluginSimpleGain::isOutputParameter(index) || index == PluginSimpleGain::paramAbSlot)
+                continue;
+            if (kParameterDescriptors[index].taper == kTaperToggle)
+                drawToggle(index);
+            else
+                drawSlider(index);
+            if (index == PluginSimpleGain::paramMorph)
+                drawMorphSnapshots();
+        }
+
+        const uint32_t meters[] = {
+            PluginSimpleGain::paramTruePeakLeft,
+            PluginSimpleGain::paramTruePeakRight,
+        };
+        for (uint32_t index : meters)
+        {
+            float level = params[index];
+            char text[32];
+            snprintf(text, sizeof(text), "%.1f dBTP", level);
+            ImGui::ProgressBar(kParameterDescriptors[index].normalize(level), ImVec2(-FLT_MIN, 0.0f), text);
+        }
+
+        // percent of the realtime budget, since the plugin was activated
+        ImGui::Text("DSP load: p50 %.2f%%, p99 %.2f%%, p99.9 %.2f%%, max %.2f%%",
+                    params[PluginSimpleGain::paramLoadP50],
+                    params[PluginSimpleGain::paramLoadP99],
+                    params[PluginSimpleGain::paramLoadP999],
+                    params[PluginSimpleGain::paramLoadMax]);
+
+        drawPresetBrowser();
+    }
+    ImGui::End();
+}
+
+void SimpleGainPanel::setParameterValue(uint32_t index, float value) {
+    if (index == PluginSimpleGain::paramAbSlot)
+        selectAbSlot((uint32_t)(kParameterDescriptors[index].clamp(value) + 0.5f));
+    params[index] = value;
+}
+
+void SimpleGainPanel::setSessionField(uint32_t tag, StateReader& field) {
+    switch (tag) {
+    case PluginSimpleGain::kStateParameters: {
+        // the live values, which the host may not know after a slot change
+        uint32_t index;
+        float value;
+        while (!field.atEnd() && field.readVarint(index) && field.readFloat(value)) {
+            if (index < PluginSimpleGain::paramCount && !PluginSimpleGain::isOutputParameter(index) &&
+                index != PluginSimpleGain::paramAbSlot)
+                params[index] = value;
+        }
+        break;
+    }
+    case PluginSimpleGain::kStateAbSlots:
+        if (fAbSlots.read(field))
+            params[PluginSimpleGain::paramAbSlot] = (float)fAbSlots.getActive();
+        break;
+    case PluginSimpleGain::kStateMorphSnapshots: {
+        // as the plugin reads it, the snapshots before a short one
+        uint32_t count;
+        if (!field.readVarint(count) || count > PluginSimpleGain::kMorphSnapshots)
+            break;
+        fMorphSnapshotCount = 0;
+        for (uint32_t s = 0; s < count; ++s) {
+            float* const row = fMorphSnapshots[s];
+            uint32_t index = 0;
+            while (index < PluginSimpleGain::paramMorph && field.readFloat(row[index]))
+                ++index;
+            if (index < PluginSimpleGain::paramMorph)
+                break;
+            fMorphSnapshotCount = s + 1;
+        }
+        break;
+    }
+    }
+}
+
+void SimpleGainPanel::selectAbSlot(uint32_t slot) {
+    if (const float* values = fAbSlots.select(slot, params))
+        std::memcpy(params, values, PluginSimpleGain::paramMorph * sizeof(float));
+}
+
+/**
+  A button per snapshot, and one for the next, which store the program
+  parameters as they are shown; the plugin receives all of them at once,
+  and the morph takes them at its next move.
+*/
+void SimpleGainPanel::drawMorphSnapshots() {
+    ImGui::TextUnformatted("Store");
+    const uint32_t buttons = std::min(fMorphSnapshotCount + 1, (uint32_t)PluginSimpleGain::kMorphSnapshots);
+    for (uint32_t snapshot = 0; snapshot < buttons; ++snapshot)
+    {
+        char label[8];
+        snprintf(label, sizeof(label), "%u", snapshot + 1);
+        ImGui::SameLine();
+        if (ImGui::Button(label))
+            storeMorphSnapshot(snapshot);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear") && fMorphSnapshotCount > 0)
+    {
+        fMorphSnapshotCount = 0;
+        sendMorphSnapshots();
+    }
+    ImGui::SameLine();
+    ImGui::Text("%u snapshot(s), %s", fMorphSnapshotCount,
+                (fMorphSnapshotCount >= 2) ? "morphing" : "two are needed");
+}
+
+void SimpleGainPanel::storeMorphSnapshot(uint32_t snapshot) {
+    std::memcpy(fMorphSnapshots[snapshot], params, sizeof(fMorphSnapshots[snapshot]));
+    fMorphSnapshotCount = std::max(fMorphSnapshotCount, snapshot + 1);
+    sendMorphSnapshots();
+}
+
+void SimpleGainPanel::sendMorphSnapshots() {
+    StateWriter writer;
+    writer.beginField(PluginSimpleGain::kStateMorphSnapshots);
+    writer.writeVarint(fMorphSnapshotCount);
+    for (uint32_t s = 0; s < fMorphSnapshotCount; ++s) {
+        for (uint32_t index = 0; index < PluginSimpleGain::paramMorph; ++index)
+            writer.writeFloat(fMorphSnapshots[s][index]);
+    }
+    writer.endField();
+    fListener->panelSetSessionState(writer.finish());
+}
+
+void SimpleGainPanel::drawSlider(uint32_t index) {
+    const ParameterDescriptor& descriptor = kParameterDescriptors[index];
+    float& value = params[index];
+    // the gesture starts with the click, which need not move the value
+    const bool changed = ImGui::SliderFloat(descriptor.name, &value, descriptor.min, descriptor.max);
+    if (ImGui::IsItemActivated())
+    {
+        fListener->panelEditParameter(index, true);
+    }
+    if (changed)
+    {
+        fListener->panelSetParameterValue(index, value);
+    }
+    if (ImGui::IsItemDeactivated())
+    {
+        fListener->panelEditParameter(index, false);
+    }
+}
+
+void SimpleGainPanel::drawToggle(uint32_t index) {
+    const ParameterDescriptor& descriptor = kParameterDescriptors[index];
+    bool enabled = descriptor.normalize(params[index]) > 0.5f;
+    if (ImGui::Checkbox(descriptor.name, &enabled))
+    {
+        params[index] = descriptor.denormalize(enabled ? 1.0f : 0.0f);
+        fListener->panelEditParameter(index, true);
+        fListener->panelSetParameterValue(index, params[index]);
+        fListener->panelEditParameter(index, false);
+    }
+}
+
+/**
+  One button per slot; a click sends the slot alone to the plugin, which
+  changes the program parameters on its side.
+*/
+void SimpleGainPanel::drawAbSlots() {
+    const uint32_t index = PluginSimpleGain::paramAbSlot;
+    for (uint32_t slot = 0; slot < PluginSimpleGain::kAbSlots; ++slot)
+    {
+        const char label[2] = {(char)('A' + slot), '\0'};
+        if (slot > 0)
+            ImGui::SameLine();
+        if (ImGui::RadioButton(label, fAbSlots.getActive() == slot) && fAbSlots.getActive() != slot)
+        {
+            setParameterValue(index, (float)slot);
+            fListener->panelEditParameter(index, true);
+            fListener->panelSetParameterValue(index, params[index]);
+            fListener->panelEditParameter(index, false);
+        }
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(kParameterDescriptors[index].name);
+}
+
+/**
+  The presets whose name contains the search text, as a list of which only
+  the visible rows are laid out; a click applies a preset.
+*/
+void SimpleGainPanel::drawPresetBrowser() {
+    ImGui::SetNextItemOpen(fPresetsOpen, ImGuiCond_Once);
+    fPresetsOpen = ImGui::CollapsingHeader("Presets");
+    if (!fPresetsOpen)
+        return;
+
+    // the bank of the process, read for this frame; indexed again when it
+    // was replaced
+    const PluginSimpleGain::PresetBankReader bank = PluginSimpleGain::getPresetBank();
+    if (!fPresetSearch.isBuiltFor(*bank)) {
+        fPresetSearch.build(*bank);
+        fPresetSearch.search(fSearchText);
+    }
+
+    if (ImGui::InputText("Search", fSearchText, sizeof(fSearchText)))
+        fPresetSearch.search(fSearchText);
+    ImGui::Text("%u of %u presets", fPresetSearch.getResultCount(), fPresetSearch.getPresetCount());
+
+    if (ImGui::BeginChild("Preset list", ImVec2(0.0f, 8.0f * ImGui::GetTextLineHeightWithSpacing()), true))
+    {
+        ImGuiListClipper clipper;
+        clipper.Begin((int)fPresetSearch.getResultCount());
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+            {
+                const uint32_t preset = fPresetSearch.getResult((uint32_t)row);
+                ImGui::PushID((int)preset);
+                if (ImGui::Selectable(bank->getPresetName(preset), fSelectedPreset == (int)preset))
+                    applyPreset(*bank, preset);
+                ImGui::SameLine(240.0f);
+                ImGui::TextDisabled("%s", bank->getPresetCategory(preset));
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+}
+
+/**
+  Set the program parameters to the values of a preset, as edits.
+*/
+void SimpleGainPanel::applyPreset(const PresetBank& bank, uint32_t preset) {
+    fSelectedPreset = (int)preset;
+    const float* const values = bank.getPresetValues(preset);
+    for (uint32_t index = 0; index < bank.getColumnCount() && PluginSimpleGain::isProgramParameter(index); ++index)
+    {
+        params[index] = values[index];
+        fListener->panelEditParameter(index, true);
+        fListener->panelSetParameterValue(index, values[index]);
+        fListener->panelEditParameter(index, false);
+    }
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
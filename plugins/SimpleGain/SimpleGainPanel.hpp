@@ -0,0 +1,104 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SIMPLEGAIN_PANEL_H
+#define SIMPLEGAIN_PANEL_H
+
+#include "PluginSimpleGain.hpp"
+#include "PresetSearch.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/**
+  The widgets of the SimpleGain UI, drawn into the current ImGui context.
+
+  This is everything UISimpleGain shows, kept apart from the window and the
+  GL renderer, so that a frame can be built and timed without either.
+*/
+class SimpleGainPanel {
+public:
+    /**
+      Receives the edits made with the widgets.
+    */
+    class Listener {
+    public:
+        virtual ~Listener() {}
+        virtual void panelEditParameter(uint32_t index, bool started) = 0;
+        virtual void panelSetParameterValue(uint32_t index, float value) = 0;
+        // a session state of some fields, for the plugin to load
+        virtual void panelSetSessionState(const std::vector<uint8_t>& state) = 0;
+    };
+
+    explicit SimpleGainPanel(Listener* listener);
+
+    float getParameterValue(uint32_t index) const { return params[index]; }
+
+    // A value from the plugin; the A/B slot changes the values shown as it
+    // does those of the plugin
+    void setParameterValue(uint32_t index, float value);
+
+    // A field of the session state of the plugin, of those which the
+    // panel shows: the parameters, the A/B slots and the morph snapshots
+    void setSessionField(uint32_t tag, StateReader& field);
+
+    /**
+      Draw the widgets in a window of the given size.
+    */
+    void draw(float width, float height);
+
+private:
+    void drawSlider(uint32_t index);
+    void drawToggle(uint32_t index);
+    void drawAbSlots();
+    void selectAbSlot(uint32_t slot);
+    void drawMorphSnapshots();
+    void storeMorphSnapshot(uint32_t snapshot);
+    void sendMorphSnapshots();
+    void drawPresetBrowser();
+    void applyPreset(const PresetBank& bank, uint32_t preset);
+
+    Listener* const fListener;
+    float params[PluginSimpleGain::paramCount] {};
+    PluginSimpleGain::AbSlotSet fAbSlots;
+
+    // those of the plugin, which the panel changes as a whole
+    float fMorphSnapshots[PluginSimpleGain::kMorphSnapshots][PluginSimpleGain::paramMorph] {};
+    uint32_t fMorphSnapshotCount = 0;
+
+    // the browser of the presets of the bank, indexed when first shown
+    PresetSearch fPresetSearch;
+    char fSearchText[64] {};
+    int fSelectedPreset = -1;
+    bool fPresetsOpen = false;  // kept when the ImGui context is not
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif  // #ifndef SIMPLEGAIN_PANEL_H
@@ -0,0 +1,170 @@
+/**
+ * True-peak level detector according to ITU-R BS.1770-4, Annex 2
+ *
+ * The signal is upsampled 4x by a 48-tap polyphase FIR (12 taps per phase,
+ * coefficients from the recommendation) and the peak absolute value of the
+ * interpolated signal is tracked.
+ *
+ * Cost is fixed and independent of the signal: for every input sample, one
+ * 4-lane multiply-add per tap (12 in total), one absolute value and one max.
+ * With SSE this is 12 broadcasts, 12 mul, 12 add, 1 and and 1 max on
+ * 128-bit vectors, per sample and channel. Only the max carries from one
+ * sample to the next, so samples overlap, and the bound is the throughput
+ * of 24 mul/add on two vector ports, or of 12 broadcasts on one shuffle
+ * port: about 12 cycles per sample per channel on x86-64, derived from the
+ * instruction count rather than measured.
+ *
+ * https://www.itu.int/rec/R-REC-BS.1770
+ */
+
+#ifndef TRUE_PEAK_METER_H
+#define TRUE_PEAK_METER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define TRUE_PEAK_USE_SSE 1
+#endif
+
+class Upsampler4x {
+public:
+    enum {
+        kPhases = 4,
+        kTaps = 12,
+    };
+
+    // one row per tap, newest sample first; one column per phase.
+    // the prototype lowpass is h[4 * tap + phase], with a gain of 4 at DC.
+    alignas(16) static constexpr float coefs[kTaps][kPhases] = {
+        { 0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f},
+        { 0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f},
+        {-0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f},
+        { 0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f},
+        {-0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f},
+        { 0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f},
+        { 0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f},
+        {-0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f},
+        { 0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f},
+        {-0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f},
+        { 0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f},
+        {-0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f},
+    };
+
+    Upsampler4x() { reset(); }
+
+    void reset() {
+        memset(hist, 0, sizeof(hist));
+        pos = 0;
+    }
+
+    /**
+      Push one input sample and compute the four interpolated output samples.
+    */
+    inline void process(float in, float out[kPhases]) {
+        const float* x = push(in);
+        float acc[kPhases] = {};
+        for (unsigned k = 0; k < kTaps; ++k) {
+            for (unsigned p = 0; p < kPhases; ++p)
+                acc[p] += coefs[k][p] * x[kTaps - 1 - k];
+        }
+        for (unsigned p = 0; p < kPhases; ++p)
+            out[p] = acc[p];
+    }
+
+    /**
+      Push a block of input samples and return the maximum absolute value
+      of the interpolated signal.
+    */
+    float processPeak(const float* in, uint32_t frames) {
+#if defined(TRUE_PEAK_USE_SSE)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peak = _mm_setzero_ps();
+        for (uint32_t i = 0; i < frames; ++i) {
+            const float* x = push(in[i]);
+            __m128 acc = _mm_setzero_ps();
+            for (unsigned k = 0; k < kTaps; ++k) {
+                __m128 c = _mm_load_ps(coefs[k]);
+                acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_set1_ps(x[kTaps - 1 - k])));
+            }
+            peak = _mm_max_ps(peak, _mm_and_ps(acc, absMask));
+        }
+        peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+        peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, 1));
+        return _mm_cvtss_f32(peak);
+#else
+        float peak = 0.0f;
+        for (uint32_t i = 0; i < frames; ++i) {
+            float out[kPhases];
+            process(in[i], out);
+            for (unsigned p = 0; p < kPhases; ++p)
+                peak = fmaxf(peak, fabsf(out[p]));
+        }
+        return peak;
+#endif
+    }
+
+private:
+    // store the sample twice so the last kTaps samples are always contiguous
+    inline const float* push(float in) {
+        hist[pos] = in;
+        hist[pos + kTaps] = in;
+        pos = (pos + 1 < kTaps) ? (pos + 1) : 0;
+        return &hist[pos];
+    }
+
+    float hist[2 * kTaps];
+    unsigned pos;
+};
+
+/**
+  Peak-programme style true-peak meter: instant attack, linear fall in dB.
+*/
+class TruePeakMeter {
+public:
+    TruePeakMeter(float fallDbPerSecond = 20.0f, float floorDb = -90.0f)
+        : fall(fallDbPerSecond), minLevel(floorDb), level(floorDb) { }
+
+    void reset() {
+        upsampler.reset();
+        level = minLevel;
+    }
+
+    // drop the level to the floor, keeping the filter history
+    void resetLevel() {
+        level = minLevel;
+    }
+
+    void setSampleRate(double samplingRate) {
+        fs = samplingRate;
+    }
+
+    /**
+      Analyze a block and return the current meter level in dBTP.
+    */
+    float process(const float* in, uint32_t frames) {
+        float peak = upsampler.processPeak(in, frames);
+        float peakDb = (peak > 0.0f) ? 20.0f * log10f(peak) : minLevel;
+        float fallen = level - fall * (float)(frames / fs);
+        level = (peakDb > fallen) ? peakDb : fallen;
+        if (level < minLevel)
+            level = minLevel;
+        return level;
+    }
+
+    float getLevel() const { return level; }
+
+    // restore a level, from which the meter falls as usual
+    void setLevel(float levelDb) {
+        level = (levelDb > minLevel) ? levelDb : minLevel;
+    }
+
+private:
+    Upsampler4x upsampler;
+    float fall, minLevel, level;
+    double fs = 44100.0;
+};
+
+#endif  // #ifndef TRUE_PEAK_METER_H
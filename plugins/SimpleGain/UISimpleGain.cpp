@@ -26,7 +26,8 @@
 
 #include "UISimpleGain.hpp"
 #include "Window.hpp"
-#include <imgui.h>
+#include <chrono>
+#include <cstring>
 
 START_NAMESPACE_DISTRHO
 
@@ -34,14 +35,26 @@ START_NAMESPACE_DISTRHO
 // Init / Deinit
 
 UISimpleGain::UISimpleGain()
-: ImGuiUI(600, 400)  {
-
+: ImGuiUI(600, 400),
+  fPanel(this),
+  fGestures(PluginSimpleGain::paramCount)  {
+    for (uint32_t index = 0; index < PluginSimpleGain::paramCount; ++index)
+        fGestures.setRange(index, kParameterDescriptors[index].min, kParameterDescriptors[index].max);
+
+    // the size of the session
+    uint width, height;
+    if (getPlugin()->getUiLayout(width, height) && width >= 200 && height >= 150)
+        setSize(width, height);
 }
 
 UISimpleGain::~UISimpleGain() {
 
 }
 
+void UISimpleGain::setGestureSettings(const GestureCoalescer::Settings& settings) {
+    fGestures.setSettings(settings);
+}
+
 // -----------------------------------------------------------------------
 // DSP/Plugin callbacks
 
@@ -50,15 +63,7 @@ UISimpleGain::~UISimpleGain() {
   This is called by the host to inform the UI about parameter changes.
 */
 void UISimpleGain::parameterChanged(uint32_t index, float value) {
-    params[index] = value;
-
-    switch (index) {
-        case PluginSimpleGain::paramGain:
-            // do something when Gain param is set, such as update a widget
-            break;
-    }
-
-    (void)value;
+    queueParameterChange(index, value);
 }
 
 /**
@@ -66,10 +71,12 @@ void UISimpleGain::parameterChanged(uint32_t index, float value) {
   This is called by the host to inform the UI about program changes.
 */
 void UISimpleGain::programLoaded(uint32_t index) {
-    if (index < presetCount) {
-        for (int i=0; i < PluginSimpleGain::paramCount; i++) {
-            // set values for each parameter and update their widgets
-            parameterChanged(i, factoryPresets[index].params[i]);
+    const PluginSimpleGain::PresetBankReader bank = PluginSimpleGain::getPresetBank();
+    if (index < bank->getPresetCount()) {
+        const float* values = bank->getPresetValues(index);
+        for (uint32_t i = 0; i < bank->getColumnCount(); i++) {
+            // set values for each parameter, for the next frame
+            queueParameterChange(i, values[i]);
         }
     }
 }
@@ -81,6 +88,34 @@ void UISimpleGain::sampleRateChanged(double newSampleRate) {
     (void)newSampleRate;
 }
 
+/**
+  A state has changed on the plugin side.
+  This is called by the host to inform the UI about state changes.
+*/
+void UISimpleGain::stateChanged(const char* key, const char* value) {
+    if (std::strcmp(key, "session") != 0)
+        return;
+
+    std::vector<uint8_t> state;
+    StateReader reader;
+    if (!decodeBase64(value, state) || !reader.open(state.data(), state.size()))
+        return;
+
+    // the changes which came before the state go first
+    applyParameterChanges();
+
+    // the layout, and what the panel shows
+    uint32_t tag;
+    StateReader field;
+    while (!reader.atEnd() && reader.nextField(tag, field)) {
+        uint32_t width, height;
+        if (tag != PluginSimpleGain::kStateUiLayout)
+            fPanel.setSessionField(tag, field);
+        else if (field.readVarint(width) && field.readVarint(height) && width >= 200 && height >= 150)
+            setSize(width, height);
+    }
+}
+
 // -----------------------------------------------------------------------
 // Widget callbacks
 
@@ -89,33 +124,84 @@ void UISimpleGain::sampleRateChanged(double newSampleRate) {
   A function called to draw the view contents.
 */
 void UISimpleGain::onImGuiDisplay() {
-    float width = getWidth();
-    float height = getHeight();
-    float margin = 20.0f;
-
-    ImGui::SetNextWindowPos(ImVec2(margin, margin));
-    ImGui::SetNextWindowSize(ImVec2(width - 2 * margin, height - 2 * margin));
-
-    if (ImGui::Begin("Simple gain")) {
-        static char aboutText[256] =
-            "This is a demo plugin made with ImGui.\n";
-        ImGui::InputTextMultiline("About", aboutText, sizeof(aboutText));
-
-        float& gain = params[PluginSimpleGain::paramGain];
-        if (ImGui::SliderFloat("Gain (dB)", &gain, -90.0f, 30.0f))
-        {
-            if (ImGui::IsItemActivated())
-            {
-                editParameter(PluginSimpleGain::paramGain, true);
-            }
-            setParameterValue(PluginSimpleGain::paramGain, gain);
-        }
-        if (ImGui::IsItemDeactivated())
-        {
-            editParameter(PluginSimpleGain::paramGain, false);
-        }
+    applyParameterChanges();
+    fPanel.draw(getWidth(), getHeight());
+
+    // the display repaints at a steady rate, so the values of a gesture
+    // which wait for their turn go out even while the mouse is still
+    fGestures.flush(getGestureTime(), [this](uint32_t index, float value) {
+        setParameterValue(index, value);
+    });
+}
+
+/**
+  The ImGui context goes with the gestures in progress, which would not see
+  their release; they end here.
+*/
+void UISimpleGain::onImGuiRelease() {
+    for (uint32_t index = 0; index < PluginSimpleGain::paramCount; ++index) {
+        if (fGestures.isActive(index))
+            panelEditParameter(index, false);
+    }
+}
+
+/**
+  The window was resized; the plugin writes the new size into the session
+  state when the host saves it, and nothing is sent meanwhile.
+*/
+void UISimpleGain::uiReshape(uint width, uint height) {
+    ImGuiUI::uiReshape(width, height);
+    getPlugin()->setUiLayout(width, height);
+}
+
+/**
+  A gesture ends with its final value, if it was held back.
+*/
+void UISimpleGain::panelEditParameter(uint32_t index, bool started) {
+    if (started) {
+        fGestures.begin(index, getGestureTime());
+        editParameter(index, true);
+    } else {
+        float value;
+        if (fGestures.end(index, value))
+            setParameterValue(index, value);
+        editParameter(index, false);
     }
-    ImGui::End();
+}
+
+void UISimpleGain::panelSetParameterValue(uint32_t index, float value) {
+    if (fGestures.change(index, value, getGestureTime()))
+        setParameterValue(index, value);
+}
+
+/**
+  Only the first change of a frame requests a repaint. A slot change
+  replaces the values which the panel holds, so the changes around it are
+  not reordered: those before it are applied first.
+*/
+void UISimpleGain::queueParameterChange(uint32_t index, float value) {
+    if (index == PluginSimpleGain::paramAbSlot)
+        applyParameterChanges();
+    if (fChanges.set(index, value))
+        repaint();
+}
+
+void UISimpleGain::applyParameterChanges() {
+    fChanges.apply([this](uint32_t index, float value) {
+        fPanel.setParameterValue(index, value);
+    });
+}
+
+void UISimpleGain::panelSetSessionState(const std::vector<uint8_t>& state) {
+    setState("session", encodeBase64(state.data(), state.size()).c_str());
+}
+
+PluginSimpleGain* UISimpleGain::getPlugin() const {
+    return static_cast<PluginSimpleGain*>(getPluginInstancePointer());
+}
+
+double UISimpleGain::getGestureTime() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 // -----------------------------------------------------------------------
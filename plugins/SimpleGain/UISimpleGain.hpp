@@ -29,24 +29,49 @@
 
 #include "DistrhoUI.hpp"
 #include "ImGuiUI.hpp"
+#include "GestureCoalescer.hpp"
+#include "ParameterChangeSet.hpp"
 #include "PluginSimpleGain.hpp"
+#include "SimpleGainPanel.hpp"
 
 START_NAMESPACE_DISTRHO
 
-class UISimpleGain : public ImGuiUI {
+class UISimpleGain : public ImGuiUI, private SimpleGainPanel::Listener {
 public:
     UISimpleGain();
     ~UISimpleGain();
 
+    // how the changes of a gesture are coalesced before they are sent
+    void setGestureSettings(const GestureCoalescer::Settings& settings);
+
 protected:
     void parameterChanged(uint32_t, float value) override;
     void programLoaded(uint32_t index) override;
     void sampleRateChanged(double newSampleRate) override;
+    void stateChanged(const char* key, const char* value) override;
 
     void onImGuiDisplay() override;
+    void onImGuiRelease() override;
+    void uiReshape(uint width, uint height) override;
 
 private:
-    float params[PluginSimpleGain::paramCount] {};
+    void panelEditParameter(uint32_t index, bool started) override;
+    void panelSetParameterValue(uint32_t index, float value) override;
+    void panelSetSessionState(const std::vector<uint8_t>& state) override;
+
+    void queueParameterChange(uint32_t index, float value);
+    void applyParameterChanges();
+
+    // the instance which the editor belongs to, see DistrhoPluginInfo.h
+    PluginSimpleGain* getPlugin() const;
+
+    static double getGestureTime();
+
+    SimpleGainPanel fPanel;
+    GestureCoalescer fGestures;
+
+    // the changes from the plugin, applied once per frame
+    ParameterChangeSet<PluginSimpleGain::paramCount> fChanges;
 
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UISimpleGain)
 };
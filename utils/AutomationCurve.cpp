@@ -0,0 +1,76 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "AutomationCurve.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+// -----------------------------------------------------------------------
+
+bool AutomationCurve::load(const char* path) {
+    points.clear();
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        error = "cannot open automation file";
+        return false;
+    }
+
+    char line[256];
+    unsigned lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++lineNumber;
+
+        const char* p = line;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+
+        char* end;
+        Point point;
+        point.time = strtod(p, &end);
+        if (end == p) {
+            ok = false;
+            break;
+        }
+        p = end;
+        point.value = strtof(p, &end);
+        if (end == p || (!points.empty() && point.time <= points.back().time)) {
+            ok = false;
+            break;
+        }
+        points.push_back(point);
+    }
+    fclose(file);
+
+    if (!ok) {
+        error = "invalid breakpoint at line " + std::to_string(lineNumber);
+        points.clear();
+    }
+    return ok;
+}
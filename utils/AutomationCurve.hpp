@@ -0,0 +1,83 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef AUTOMATION_CURVE_H
+#define AUTOMATION_CURVE_H
+
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Piecewise-linear parameter automation.
+
+  The sidecar file has one breakpoint per line, a time in seconds and a
+  value in the unit of the parameter, separated by blanks. Times must be
+  increasing. Empty lines and lines starting with '#' are ignored.
+  Before the first breakpoint and after the last, the value is held.
+*/
+class AutomationCurve {
+public:
+    struct Point {
+        double time;
+        float value;
+    };
+
+    bool load(const char* path);
+
+    const std::string& getError() const { return error; }
+    bool isEmpty() const { return points.empty(); }
+
+    /**
+      Evaluate at the given time. The hint is the index of the segment found
+      by the previous call; evaluating at increasing times costs O(1).
+    */
+    float valueAt(double time, size_t& hint) const {
+        const size_t count = points.size();
+        if (count == 0)
+            return 0.0f;
+        if (hint >= count || points[hint].time > time)
+            hint = 0;
+        while (hint + 1 < count && points[hint + 1].time <= time)
+            ++hint;
+
+        const Point& a = points[hint];
+        if (hint + 1 == count || time <= a.time)
+            return a.value;
+        const Point& b = points[hint + 1];
+        const double t = (time - a.time) / (b.time - a.time);
+        return (float)(a.value + (b.value - a.value) * t);
+    }
+
+private:
+    std::vector<Point> points;
+    std::string error;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef AUTOMATION_CURVE_H
@@ -0,0 +1,145 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "ChunkedRenderer.hpp"
+#include "WavFile.hpp"
+#include <algorithm>
+#include <chrono>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+// chunks per worker, for the load to even out
+static const uint32_t kChunksPerThread = 4;
+
+ChunkedRenderer::ChunkedRenderer(const RenderOptions& options, unsigned threadCount)
+    : fOptions(options),
+      fTracker(options),
+      fPool(threadCount, threadCount * kChunksPerThread + 1)
+{
+    for (unsigned i = 0; i < threadCount; ++i)
+        fRenderers.emplace_back(new OfflineRenderer(options));
+}
+
+void ChunkedRenderer::runTask(void* context, uint32_t task, unsigned worker) {
+    ChunkedRenderer* self = (ChunkedRenderer*)context;
+
+    if (task == 0) {
+        // the serial pass, task i + 1 renders chunk i
+        for (uint32_t i = 0; i < self->fChunks.size(); ++i) {
+            Chunk& chunk = self->fChunks[i];
+            if (chunk.start > 0)
+                chunk.smoothedGain = self->fTracker.trackSmoothedGain(chunk.start - OfflineRenderer::kChunkPreroll);
+            self->fPool.spawn(worker, i + 1);
+        }
+        return;
+    }
+
+    Chunk& chunk = self->fChunks[task - 1];
+    chunk.ok = self->fRenderers[worker]->renderChunk(*self->fReader, *self->fWriter,
+                                                     chunk.start, chunk.end,
+                                                     chunk.smoothedGain, chunk.truePeakDb);
+}
+
+bool ChunkedRenderer::render(const char* inputPath, const char* outputPath, RenderStats& stats) {
+    const auto startTime = std::chrono::steady_clock::now();
+    fChunks.assign(1, Chunk());
+
+    WavReader reader;
+    if (!reader.open(inputPath)) {
+        error = std::string(inputPath) + ": " + reader.getError();
+        return false;
+    }
+
+    const WavFormat& format = reader.getFormat();
+    const uint64_t frameCount = reader.getFrameCount();
+    const uint32_t blockSize = fOptions.blockSize;
+    const unsigned threadCount = fPool.getThreadCount();
+
+    // chunks start on block boundaries, so that every run() call is the
+    // same as in a sequential render
+    uint64_t chunkFrames = (frameCount + threadCount * kChunksPerThread - 1) / (threadCount * kChunksPerThread);
+    chunkFrames = std::max<uint64_t>(1, (chunkFrames + blockSize - 1) / blockSize) * blockSize;
+
+    // the preroll of a chunk is within the one before, and runs in blocks
+    // of the block size, however short
+    if (format.channels > 2 || threadCount < 2 || frameCount <= chunkFrames ||
+        chunkFrames < OfflineRenderer::kChunkPreroll || !fTracker.beginChunks(format.sampleRate)) {
+        reader.close();
+        if (!fTracker.render(inputPath, outputPath, stats)) {
+            error = fTracker.getError();
+            return false;
+        }
+        return true;
+    }
+
+    WavWriter writer;
+    if (!writer.open(outputPath, format) || !writer.reserve(frameCount)) {
+        error = std::string(outputPath) + ": " + writer.getError();
+        return false;
+    }
+
+    fChunks.clear();
+    for (uint64_t start = 0; start < frameCount; start += chunkFrames)
+        fChunks.push_back(Chunk {start, std::min(start + chunkFrames, frameCount), 0.0f, -90.0f, false});
+
+    for (const std::unique_ptr<OfflineRenderer>& renderer : fRenderers)
+        renderer->beginChunks(format.sampleRate);
+
+    fReader = &reader;
+    fWriter = &writer;
+    const uint32_t serialPass = 0;
+    if (fPool.start(&serialPass, 1, (uint32_t)fChunks.size() + 1, &runTask, this))
+        fPool.wait();
+    fReader = nullptr;
+    fWriter = nullptr;
+
+    stats = RenderStats();
+    stats.sampleRate = format.sampleRate;
+    bool ok = true;
+    for (const Chunk& chunk : fChunks) {
+        ok = ok && chunk.ok;
+        stats.truePeakDb = std::max(stats.truePeakDb, chunk.truePeakDb);
+    }
+
+    if (!ok) {
+        error = std::string(outputPath) + ": write error";
+        return false;
+    }
+    if (!writer.close()) {
+        error = std::string(outputPath) + ": " + writer.getError();
+        return false;
+    }
+
+    stats.frames = frameCount;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
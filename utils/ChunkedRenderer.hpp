@@ -0,0 +1,91 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef CHUNKED_RENDERER_H
+#define CHUNKED_RENDERER_H
+
+#include "OfflineRenderer.hpp"
+#include "WorkStealingPool.hpp"
+#include <memory>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/**
+  Renders one WAV file in chunks on several threads, bit-identical to
+  OfflineRenderer::render().
+
+  The plugin state at the start of each chunk is restored exactly. A serial
+  pass runs the gain automation through the smoother alone, which costs
+  little, and spawns the render of each chunk as soon as the smoothed gain
+  at its start is known; the other workers steal the chunks in order.
+
+  When the plugin can not be resumed (the limiter is on), or the file is
+  too short to split, the file is rendered sequentially.
+*/
+class ChunkedRenderer {
+public:
+    ChunkedRenderer(const RenderOptions& options, unsigned threadCount);
+
+    bool render(const char* inputPath, const char* outputPath, RenderStats& stats);
+
+    const std::string& getError() const { return error; }
+
+    // chunks of the last render, 1 if it was sequential
+    uint32_t getChunkCount() const { return (uint32_t)fChunks.size(); }
+
+private:
+    struct Chunk {
+        uint64_t start, end;
+        float smoothedGain;
+        float truePeakDb;
+        bool ok;
+    };
+
+    static void runTask(void* context, uint32_t task, unsigned worker);
+
+    const RenderOptions fOptions;
+    std::string error;
+
+    // runs the serial pass, and whole files which can not be split
+    OfflineRenderer fTracker;
+    std::vector<std::unique_ptr<OfflineRenderer>> fRenderers;
+    WorkStealingPool fPool;
+
+    // the current file
+    std::vector<Chunk> fChunks;
+    const WavReader* fReader = nullptr;
+    const WavWriter* fWriter = nullptr;
+
+    DISTRHO_DECLARE_NON_COPYABLE(ChunkedRenderer)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif  // #ifndef CHUNKED_RENDERER_H
@@ -0,0 +1,52 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "HeadlessPlugin.hpp"
+#include "src/DistrhoPlugin.cpp"
+#include <mutex>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+HeadlessPlugin* HeadlessPlugin::create(double sampleRate, uint32_t bufferSize, GainBatch* sharedGains) {
+    // Plugin reads its initial configuration from these globals,
+    // which the host wrappers set before instantiating
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    d_lastSampleRate = sampleRate;
+    d_lastBufferSize = bufferSize;
+    return new HeadlessPlugin(sharedGains);
+}
+
+int HeadlessPlugin::findParameter(const char* symbol) {
+    return findParameterBySymbol(symbol);
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,75 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HEADLESS_PLUGIN_H
+#define HEADLESS_PLUGIN_H
+
+#include "PluginSimpleGain.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/**
+  PluginSimpleGain driven directly, without any host wrapper.
+
+  The DSP callbacks are made public so tools can call them. The instance
+  behaves as if a host had created it at the given sample rate and buffer
+  size; call activate() before run().
+*/
+class HeadlessPlugin : public PluginSimpleGain {
+public:
+    /**
+      Create an instance, optionally with its gain stage in a slot of a
+      shared batch. This is safe to call from several threads.
+    */
+    static HeadlessPlugin* create(double sampleRate, uint32_t bufferSize, GainBatch* sharedGains = nullptr);
+
+    using PluginSimpleGain::initParameter;
+    using PluginSimpleGain::getParameterValue;
+    using PluginSimpleGain::setParameterValue;
+    using PluginSimpleGain::loadProgram;
+    using PluginSimpleGain::setState;
+    using PluginSimpleGain::sampleRateChanged;
+    using PluginSimpleGain::activate;
+    using PluginSimpleGain::run;
+
+    /**
+      Find a parameter by symbol, returns -1 if there is none.
+    */
+    int findParameter(const char* symbol);
+
+private:
+    explicit HeadlessPlugin(GainBatch* sharedGains) : PluginSimpleGain(sharedGains) {}
+
+    DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HeadlessPlugin)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif  // #ifndef HEADLESS_PLUGIN_H
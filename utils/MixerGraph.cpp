@@ -0,0 +1,215 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "MixerGraph.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GLIBC__)
+# include <malloc.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+MixerGraph::MixerGraph(const Layout& layout, double sampleRate, uint32_t blockSize, unsigned threadCount)
+    : fBlockSize(blockSize),
+      fSignal(new float[2 * blockSize]),
+      fPool(threadCount, layout.instances)
+{
+    const uint32_t total = layout.instances;
+    const uint32_t length = layout.chainLength ? layout.chainLength : 1;
+    const uint32_t fanIn = layout.tracksPerBus ? layout.tracksPerBus : 1;
+
+    // as many tracks as fit with their buses and the master
+    uint32_t tracks = 0;
+    while (length * ((tracks + 1) + (tracks + fanIn) / fanIn + 1) <= total)
+        ++tracks;
+
+    // noise at -12 dBFS
+    uint32_t random = 1;
+    for (uint32_t i = 0; i < 2 * blockSize; ++i) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        fSignal[i] = 0.25f * ((float)(int32_t)random / 2147483648.0f);
+    }
+
+    fNodes.reserve(total);
+    size_t heapUsed = 0;
+    for (uint32_t i = 0; i < total; ++i) {
+        const size_t before = heapInUse();
+        HeadlessPlugin* plugin = HeadlessPlugin::create(sampleRate, blockSize);
+        const size_t used = heapInUse() - before;
+        // besides the object itself
+        heapUsed += (used > sizeof(HeadlessPlugin)) ? (used - sizeof(HeadlessPlugin)) : 0;
+
+        fNodes.emplace_back(new Node);
+        Node& node = *fNodes.back();
+        node.plugin = plugin;
+        node.output.reset(new float[2 * blockSize]());
+    }
+    fHeapPerInstance = total ? heapUsed / total : 0;
+
+    if (tracks == 0) {
+        // too few for a mixer, a single chain
+        fTrackCount = 1;
+        addStrip(total, {});
+    }
+    else {
+        const uint32_t buses = (tracks + fanIn - 1) / fanIn;
+        const uint32_t extra = total - length * (tracks + buses + 1);
+        fTrackCount = tracks;
+        fBusCount = buses;
+
+        // the instances left over lengthen the tracks
+        std::vector<uint32_t> trackEnds;
+        for (uint32_t t = 0; t < tracks; ++t)
+            trackEnds.push_back(addStrip(length + extra / tracks + (t < extra % tracks), {}));
+
+        std::vector<uint32_t> busEnds;
+        for (uint32_t b = 0; b < buses; ++b) {
+            const uint32_t first = b * fanIn;
+            const uint32_t last = std::min(first + fanIn, tracks);
+            busEnds.push_back(addStrip(length, std::vector<uint32_t>(trackEnds.begin() + first, trackEnds.begin() + last)));
+        }
+
+        addStrip(length, busEnds);
+    }
+
+    for (uint32_t i = 0; i < total; ++i) {
+        Node& node = *fNodes[i];
+        node.dependencies = (uint32_t)node.inputs.size();
+        node.pending.store(node.dependencies, std::memory_order_relaxed);
+        if (node.inputs.size() > 1)
+            node.mix.reset(new float[2 * blockSize]());
+        else if (node.inputs.empty())
+            fSources.push_back(i);
+    }
+
+    for (const std::unique_ptr<Node>& node : fNodes)
+        node->plugin->activate();
+}
+
+MixerGraph::~MixerGraph() {
+    for (const std::unique_ptr<Node>& node : fNodes)
+        delete node->plugin;
+}
+
+size_t MixerGraph::getBufferSizePerInstance() const {
+    size_t size = 0;
+    for (const std::unique_ptr<Node>& node : fNodes)
+        size += (node->mix ? 2 : 1) * 2 * fBlockSize * sizeof(float);
+    return fNodes.empty() ? 0 : size / fNodes.size();
+}
+
+/**
+  Wire the next instances in series, the first one fed by the inputs.
+  Returns the last one.
+*/
+uint32_t MixerGraph::addStrip(uint32_t length, const std::vector<uint32_t>& inputs) {
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        const uint32_t index = fWired++;
+        Node& node = *fNodes[index];
+        if (i == 0) {
+            node.inputs = inputs;
+            for (uint32_t input : inputs)
+                fNodes[input]->successors.push_back(index);
+            // the tracks are mixed down a little, the ends of the buses
+            // and of the master are limited
+            node.plugin->setParameterValue(PluginSimpleGain::paramGain, inputs.empty() ? -12.0f : 0.0f);
+        }
+        else {
+            node.inputs.assign(1, previous);
+            fNodes[previous]->successors.push_back(index);
+        }
+        if (i + 1 == length && !inputs.empty())
+            node.plugin->setParameterValue(PluginSimpleGain::paramLimiter, 1.0f);
+        previous = index;
+    }
+    return previous;
+}
+
+void MixerGraph::process() {
+    if (fPool.start(fSources.data(), (uint32_t)fSources.size(), (uint32_t)fNodes.size(), &runTask, this))
+        fPool.wait();
+}
+
+void MixerGraph::runTask(void* context, uint32_t task, unsigned worker) {
+    ((MixerGraph*)context)->runNode(task, worker);
+}
+
+void MixerGraph::runNode(uint32_t index, unsigned worker) {
+    Node& node = *fNodes[index];
+    const uint32_t frames = fBlockSize;
+
+    // all the inputs have completed, so it is ready for the next block
+    node.pending.store(node.dependencies, std::memory_order_relaxed);
+
+    const float* inputs[2];
+    if (node.inputs.empty()) {
+        inputs[0] = &fSignal[0];
+        inputs[1] = &fSignal[frames];
+    }
+    else if (node.inputs.size() == 1) {
+        const float* output = fNodes[node.inputs[0]]->output.get();
+        inputs[0] = output;
+        inputs[1] = output + frames;
+    }
+    else {
+        float* mix = node.mix.get();
+        memcpy(mix, fNodes[node.inputs[0]]->output.get(), 2 * frames * sizeof(float));
+        for (size_t i = 1; i < node.inputs.size(); ++i) {
+            const float* output = fNodes[node.inputs[i]]->output.get();
+            for (uint32_t j = 0; j < 2 * frames; ++j)
+                mix[j] += output[j];
+        }
+        inputs[0] = mix;
+        inputs[1] = mix + frames;
+    }
+
+    float* outputs[2] = {node.output.get(), node.output.get() + frames};
+    node.plugin->run(inputs, outputs, frames);
+
+    for (uint32_t successor : node.successors) {
+        if (fNodes[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            fPool.spawn(worker, successor);
+    }
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
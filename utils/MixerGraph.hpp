@@ -0,0 +1,112 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MIXER_GRAPH_H
+#define MIXER_GRAPH_H
+
+#include "HeadlessPlugin.hpp"
+#include "WorkStealingPool.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/**
+  Many PluginSimpleGain instances wired like the strips of a mixer.
+
+  Tracks are chains of instances in series, fed by a test signal. Groups
+  of tracks are summed into buses, and the buses into the master; each bus
+  and the master are chains as well. The instances are the tasks of a
+  graph, run once per block on a work-stealing pool: a task makes its
+  successors ready as the last of their inputs completes.
+*/
+class MixerGraph {
+public:
+    struct Layout {
+        uint32_t instances = 500;
+        uint32_t chainLength = 4;   // instances in series per strip
+        uint32_t tracksPerBus = 8;
+    };
+
+    MixerGraph(const Layout& layout, double sampleRate, uint32_t blockSize, unsigned threadCount);
+    ~MixerGraph();
+
+    uint32_t getInstanceCount() const { return (uint32_t)fNodes.size(); }
+    const HeadlessPlugin& getInstance(uint32_t index) const { return *fNodes[index]->plugin; }
+    uint32_t getTrackCount() const { return fTrackCount; }
+    uint32_t getBusCount() const { return fBusCount; }
+
+    /**
+      Process one block through the whole graph.
+    */
+    void process();
+
+    /**
+      Memory of one instance: the object, what its construction allocated
+      besides the object, including the malloc overhead, and the audio
+      buffers of its node.
+    */
+    size_t getObjectSize() const { return sizeof(HeadlessPlugin); }
+    size_t getHeapSizePerInstance() const { return fHeapPerInstance; }
+    size_t getBufferSizePerInstance() const;
+
+private:
+    struct Node {
+        HeadlessPlugin* plugin = nullptr;
+        std::vector<uint32_t> inputs;
+        std::vector<uint32_t> successors;
+        uint32_t dependencies = 0;
+        std::atomic<uint32_t> pending {0};
+        // the sum of several inputs, and the output
+        std::unique_ptr<float[]> mix;
+        std::unique_ptr<float[]> output;
+    };
+
+    uint32_t addStrip(uint32_t length, const std::vector<uint32_t>& inputs);
+    void runNode(uint32_t index, unsigned worker);
+    static void runTask(void* context, uint32_t task, unsigned worker);
+
+    const uint32_t fBlockSize;
+    std::vector<std::unique_ptr<Node>> fNodes;
+    std::vector<uint32_t> fSources;
+    std::unique_ptr<float[]> fSignal;
+    uint32_t fTrackCount = 0;
+    uint32_t fBusCount = 0;
+    uint32_t fWired = 0;
+    size_t fHeapPerInstance = 0;
+    WorkStealingPool fPool;
+
+    DISTRHO_DECLARE_NON_COPYABLE(MixerGraph)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif  // #ifndef MIXER_GRAPH_H
@@ -0,0 +1,298 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "OfflineRenderer.hpp"
+#include "SampleConvert.hpp"
+#include "WavFile.hpp"
+#include <algorithm>
+#include <chrono>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+OfflineRenderer::OfflineRenderer(const RenderOptions& options)
+    : fOptions(options)
+{
+    const uint32_t blockSize = fOptions.blockSize;
+    fInterleaved.resize(2 * blockSize);
+    for (std::vector<float>& buffer : fPlanar)
+        buffer.resize(blockSize);
+}
+
+OfflineRenderer::~OfflineRenderer() {
+    delete fPlugin;
+}
+
+void OfflineRenderer::preparePlugin(double sampleRate) {
+    if (!fPlugin)
+        fPlugin = HeadlessPlugin::create(sampleRate, fOptions.blockSize);
+    else if (sampleRate != fSampleRate)
+        fPlugin->sampleRateChanged(sampleRate);
+    fSampleRate = sampleRate;
+
+    for (const std::pair<uint32_t, float>& param : fOptions.parameters)
+        fPlugin->setParameterValue(param.first, param.second);
+
+    fAutomationHint = 0;
+    if (fOptions.gainAutomation)
+        fPlugin->setParameterValue(PluginSimpleGain::paramGain,
+                                   fOptions.gainAutomation->valueAt(0.0, fAutomationHint));
+
+    fPlugin->activate();
+}
+
+/**
+  Decode a block of the input into fPlanar[0..1], with silence past the end.
+*/
+void OfflineRenderer::decodeBlock(const WavReader& reader, uint64_t position, uint32_t frames) {
+    const WavFormat& format = reader.getFormat();
+    const uint32_t channels = format.channels;
+    const uint64_t frameCount = reader.getFrameCount();
+
+    uint32_t available = 0;
+    if (position < frameCount)
+        available = (uint32_t)((frameCount - position < frames) ? (frameCount - position) : frames);
+
+    float* planarIn[2] = {fPlanar[0].data(), (channels == 2) ? fPlanar[1].data() : fPlanar[0].data()};
+    decodeSamples(format, reader.getFrameData(position), fInterleaved.data(), (size_t)available * channels);
+    deinterleave(fInterleaved.data(), planarIn, channels, available);
+    for (uint32_t i = available; i < frames; ++i)
+        planarIn[0][i] = 0.0f;
+    if (channels == 1)
+        std::copy(fPlanar[0].begin(), fPlanar[0].begin() + frames, fPlanar[1].begin());
+    else
+        for (uint32_t i = available; i < frames; ++i)
+            planarIn[1][i] = 0.0f;
+}
+
+/**
+  Encode frames of fPlanar[2..3], from the given offset, into fEncoded.
+*/
+void OfflineRenderer::encodeBlock(const WavFormat& format, uint32_t offset, uint32_t frames) {
+    const float* out[2] = {fPlanar[2].data() + offset, fPlanar[3].data() + offset};
+    interleave(out, fInterleaved.data(), format.channels, frames);
+    encodeSamples(format, fInterleaved.data(), fEncoded.data(), (size_t)frames * format.channels);
+}
+
+void OfflineRenderer::setAutomatedGain(uint64_t position) {
+    const float gain = fOptions.gainAutomation->valueAt(position / fSampleRate, fAutomationHint);
+    fPlugin->setParameterValue(PluginSimpleGain::paramGain, gain);
+}
+
+/**
+  Process one block from fPlanar[0..1] to fPlanar[2..3], or only advance
+  the gain smoother if not audio.
+  With automation, the block is split at multiples of the control interval.
+*/
+void OfflineRenderer::runBlock(uint64_t position, uint32_t frames, bool audio) {
+    const float* inputs[2] = {fPlanar[0].data(), fPlanar[1].data()};
+    float* outputs[2] = {fPlanar[2].data(), fPlanar[3].data()};
+
+    if (!fOptions.gainAutomation) {
+        if (audio)
+            fPlugin->run(inputs, outputs, frames);
+        else
+            fPlugin->skipFrames(frames);
+        return;
+    }
+
+    const uint32_t interval = fOptions.controlInterval;
+    uint32_t done = 0;
+    while (done < frames) {
+        const uint64_t now = position + done;
+        uint32_t count = interval - (uint32_t)(now % interval);
+        if (count > frames - done)
+            count = frames - done;
+
+        if (now % interval == 0)
+            setAutomatedGain(now);
+
+        if (audio) {
+            const float* in[2] = {inputs[0] + done, inputs[1] + done};
+            float* out[2] = {outputs[0] + done, outputs[1] + done};
+            fPlugin->run(in, out, count);
+        } else {
+            fPlugin->skipFrames(count);
+        }
+        done += count;
+    }
+}
+
+bool OfflineRenderer::render(const char* inputPath, const char* outputPath, RenderStats& stats) {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    WavReader reader;
+    if (!reader.open(inputPath)) {
+        error = std::string(inputPath) + ": " + reader.getError();
+        return false;
+    }
+
+    const WavFormat& format = reader.getFormat();
+    if (format.channels > 2) {
+        error = std::string(inputPath) + ": only mono and stereo files are supported";
+        return false;
+    }
+
+    WavWriter writer;
+    if (!writer.open(outputPath, format)) {
+        error = std::string(outputPath) + ": " + writer.getError();
+        return false;
+    }
+
+    preparePlugin(format.sampleRate);
+
+    const uint32_t blockSize = fOptions.blockSize;
+    const uint64_t frameCount = reader.getFrameCount();
+    fEncoded.resize((size_t)blockSize * format.bytesPerFrame());
+
+    // run past the end of the input to flush the latency, then drop as
+    // many frames from the start of the output
+    uint64_t skip = fPlugin->getLatencyFrames();
+    const uint64_t totalFrames = frameCount + skip;
+
+    stats = RenderStats();
+    stats.sampleRate = format.sampleRate;
+
+    for (uint64_t position = 0; position < totalFrames;) {
+        uint32_t frames = blockSize;
+        if (totalFrames - position < frames)
+            frames = (uint32_t)(totalFrames - position);
+
+        decodeBlock(reader, position, frames);
+        runBlock(position, frames);
+
+        if (RenderProgress* progress = fOptions.progress) {
+            const uint64_t available = (position < frameCount) ? std::min<uint64_t>(frames, frameCount - position) : 0;
+            progress->bytes.fetch_add(available * format.bytesPerFrame(), std::memory_order_relaxed);
+            progress->audioMicroseconds.fetch_add((uint64_t)(available * 1e6 / format.sampleRate), std::memory_order_relaxed);
+        }
+        position += frames;
+
+        stats.truePeakDb = std::max(stats.truePeakDb, std::max(
+            fPlugin->getParameterValue(PluginSimpleGain::paramTruePeakLeft),
+            fPlugin->getParameterValue(PluginSimpleGain::paramTruePeakRight)));
+
+        // write what remains after the latency
+        uint32_t offset = 0;
+        if (skip > 0) {
+            offset = (uint32_t)((skip < frames) ? skip : frames);
+            skip -= offset;
+        }
+        const uint32_t count = frames - offset;
+        if (count == 0)
+            continue;
+
+        encodeBlock(format, offset, count);
+        if (!writer.write(fEncoded.data(), count)) {
+            error = std::string(outputPath) + ": " + writer.getError();
+            return false;
+        }
+    }
+
+    if (!writer.close()) {
+        error = std::string(outputPath) + ": " + writer.getError();
+        return false;
+    }
+
+    stats.frames = frameCount;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// Chunks
+
+bool OfflineRenderer::beginChunks(double sampleRate) {
+    preparePlugin(sampleRate);
+    fTrackPosition = 0;
+    return fPlugin->canResume();
+}
+
+float OfflineRenderer::trackSmoothedGain(uint64_t frame) {
+    while (fTrackPosition < frame) {
+        uint32_t frames = fOptions.blockSize;
+        if (frame - fTrackPosition < frames)
+            frames = (uint32_t)(frame - fTrackPosition);
+        runBlock(fTrackPosition, frames, false);
+        fTrackPosition += frames;
+    }
+    return fPlugin->getSmoothedGain();
+}
+
+bool OfflineRenderer::renderChunk(const WavReader& reader, const WavWriter& writer,
+                                  uint64_t start, uint64_t end, float smoothedGain, float& truePeakDb) {
+    const WavFormat& format = reader.getFormat();
+    fEncoded.resize((size_t)fOptions.blockSize * format.bytesPerFrame());
+    fPlugin->activate();
+    truePeakDb = -90.0f;
+
+    if (start > 0) {
+        // resume where the previous frame leaves the plugin, with the gain
+        // set at the last control point, then run the preroll unheard
+        const uint64_t resumeFrame = start - kChunkPreroll;
+        if (fOptions.gainAutomation) {
+            fAutomationHint = 0;
+            setAutomatedGain(resumeFrame - resumeFrame % fOptions.controlInterval);
+        }
+        decodeBlock(reader, resumeFrame - 1, 1);
+        fPlugin->resume(smoothedGain, fPlanar[0][0], fPlanar[1][0]);
+        // in blocks no longer than those the buffers and the plugin take
+        for (uint64_t position = resumeFrame; position < start;) {
+            const uint32_t frames = (uint32_t)std::min<uint64_t>(fOptions.blockSize, start - position);
+            decodeBlock(reader, position, frames);
+            runBlock(position, frames);
+            position += frames;
+        }
+        fPlugin->resetMeterLevels();
+    }
+
+    for (uint64_t position = start; position < end;) {
+        uint32_t frames = fOptions.blockSize;
+        if (end - position < frames)
+            frames = (uint32_t)(end - position);
+
+        decodeBlock(reader, position, frames);
+        runBlock(position, frames);
+
+        truePeakDb = std::max(truePeakDb, std::max(
+            fPlugin->getParameterValue(PluginSimpleGain::paramTruePeakLeft),
+            fPlugin->getParameterValue(PluginSimpleGain::paramTruePeakRight)));
+
+        encodeBlock(format, 0, frames);
+        if (!writer.writeAt(position, fEncoded.data(), frames)) {
+            error = "write error";
+            return false;
+        }
+        position += frames;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
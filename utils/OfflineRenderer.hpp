@@ -0,0 +1,143 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef OFFLINE_RENDERER_H
+#define OFFLINE_RENDERER_H
+
+#include "AutomationCurve.hpp"
+#include "HeadlessPlugin.hpp"
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+class WavReader;
+class WavWriter;
+struct WavFormat;
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+/**
+  Counters updated after each block, may be shared by several renderers.
+*/
+struct RenderProgress {
+    std::atomic<uint64_t> bytes {0};
+    std::atomic<uint64_t> audioMicroseconds {0};
+};
+
+struct RenderOptions {
+    // frames passed to each run() call
+    uint32_t blockSize = 8192;
+    // frames between automation updates, run() is split at these points
+    uint32_t controlInterval = 64;
+    // fixed parameter values, as (index, value)
+    std::vector<std::pair<uint32_t, float>> parameters;
+    // gain automation, or null
+    const AutomationCurve* gainAutomation = nullptr;
+    // progress counters, or null
+    RenderProgress* progress = nullptr;
+};
+
+struct RenderStats {
+    uint64_t frames = 0;
+    double sampleRate = 0.0;
+    double seconds = 0.0;
+    float truePeakDb = -90.0f;
+};
+
+/**
+  Renders WAV files through a PluginSimpleGain instance.
+
+  The instance is kept from one file to the next, so render() can be called
+  repeatedly; it is activated anew for each file. The output has the format
+  of the input, and the plugin latency is compensated.
+*/
+class OfflineRenderer {
+public:
+    explicit OfflineRenderer(const RenderOptions& options);
+    ~OfflineRenderer();
+
+    bool render(const char* inputPath, const char* outputPath, RenderStats& stats);
+
+    const std::string& getError() const { return error; }
+
+    // -------------------------------------------------------------------
+    // Rendering one file in chunks, see ChunkedRenderer
+
+    // frames run before a chunk to settle the true-peak filter history
+    static const uint32_t kChunkPreroll = 16;
+
+    /**
+      Set up the plugin for a file at the given rate.
+      Returns false if the settings give the plugin a state which can not be
+      resumed at an arbitrary frame.
+    */
+    bool beginChunks(double sampleRate);
+
+    /**
+      The smoothed gain at a frame, that is, after the frame before it.
+      The automation is run through the smoother alone, without audio;
+      the frames asked for must be increasing.
+    */
+    float trackSmoothedGain(uint64_t frame);
+
+    /**
+      Render the frames [start, end) of the input at their place in the
+      output. Unless start is 0, the plugin is resumed kChunkPreroll frames
+      before start, where the smoothed gain is the given one.
+    */
+    bool renderChunk(const WavReader& reader, const WavWriter& writer,
+                     uint64_t start, uint64_t end, float smoothedGain, float& truePeakDb);
+
+private:
+    void preparePlugin(double sampleRate);
+    void decodeBlock(const WavReader& reader, uint64_t position, uint32_t frames);
+    void encodeBlock(const WavFormat& format, uint32_t offset, uint32_t frames);
+    void runBlock(uint64_t position, uint32_t frames, bool audio = true);
+    void setAutomatedGain(uint64_t position);
+
+    const RenderOptions fOptions;
+    HeadlessPlugin* fPlugin = nullptr;
+    double fSampleRate = 0.0;
+    std::string error;
+
+    // interleaved scratch, planar input and output
+    std::vector<float> fInterleaved;
+    std::vector<float> fPlanar[4];
+    std::vector<uint8_t> fEncoded;
+    size_t fAutomationHint = 0;
+    uint64_t fTrackPosition = 0;
+
+    DISTRHO_DECLARE_NON_COPYABLE(OfflineRenderer)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif  // #ifndef OFFLINE_RENDERER_H
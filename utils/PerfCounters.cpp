@@ -0,0 +1,152 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "PerfCounters.hpp"
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------
+
+const char* PerfCounters::getName(Counter counter) {
+    switch (counter) {
+    case kCycles: return "cycles";
+    case kInstructions: return "instructions";
+    case kL1DMisses: return "L1D misses";
+    case kLLCMisses: return "LLC misses";
+    case kBranchMisses: return "branch misses";
+    default: return "";
+    }
+}
+
+#if defined(__linux__)
+
+static int openCounter(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t cacheMissConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool PerfCounters::open() {
+    close();
+
+    const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[kCounterCount] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+
+    int lastErrno = 0;
+    bool any = false;
+    for (unsigned i = 0; i < kCounterCount; ++i) {
+        fds[i] = openCounter(events[i].type, events[i].config);
+        if (fds[i] >= 0)
+            any = true;
+        else
+            lastErrno = errno;
+    }
+
+    if (!any) {
+        if (lastErrno == EACCES || lastErrno == EPERM)
+            error = "access denied, see /proc/sys/kernel/perf_event_paranoid";
+        else if (lastErrno == ENOENT || lastErrno == EOPNOTSUPP || lastErrno == ENODEV)
+            error = "no hardware counters on this machine";
+        else
+            error = strerror(lastErrno);
+    }
+    return any;
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds) {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+}
+
+void PerfCounters::start() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounters::stop() {
+    for (int fd : fds) {
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (unsigned i = 0; i < kCounterCount; ++i) {
+        counts[i] = 0;
+        uint64_t values[3];  // value, time enabled, time running
+        if (fds[i] < 0 || read(fds[i], values, sizeof(values)) != (ssize_t)sizeof(values))
+            continue;
+        // extrapolate when the counter shared the hardware with others
+        if (values[2] > 0 && values[2] < values[1])
+            counts[i] = (uint64_t)((double)values[0] * (double)values[1] / (double)values[2]);
+        else
+            counts[i] = values[0];
+    }
+}
+
+#else
+
+bool PerfCounters::open() {
+    error = "performance counters are only supported on Linux";
+    return false;
+}
+
+void PerfCounters::close() {}
+void PerfCounters::start() {}
+void PerfCounters::stop() {}
+
+#endif
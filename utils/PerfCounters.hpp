@@ -0,0 +1,84 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// -----------------------------------------------------------------------
+
+/**
+  Hardware performance counters of the calling thread, with perf_event_open.
+
+  Each counter is opened on its own, so that the ones the CPU or the
+  virtual machine lacks do not prevent the others. Counts are scaled when
+  the kernel multiplexes them. When access is denied (perf_event_paranoid,
+  containers), open() fails and explains why. Linux only.
+*/
+class PerfCounters {
+public:
+    enum Counter {
+        kCycles,
+        kInstructions,
+        kL1DMisses,
+        kLLCMisses,
+        kBranchMisses,
+        kCounterCount
+    };
+
+    PerfCounters() {}
+    ~PerfCounters() { close(); }
+
+    // true if at least one counter could be opened
+    bool open();
+    void close();
+
+    const std::string& getError() const { return error; }
+
+    void start();
+    void stop();
+
+    bool isAvailable(Counter counter) const { return fds[counter] >= 0; }
+
+    // counts between start() and stop(), 0 if not available
+    uint64_t getCount(Counter counter) const { return counts[counter]; }
+
+    static const char* getName(Counter counter);
+
+private:
+    int fds[kCounterCount] = {-1, -1, -1, -1, -1};
+    uint64_t counts[kCounterCount] = {};
+    std::string error;
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef PERF_COUNTERS_H
@@ -0,0 +1,285 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// the fortified inline wrappers of read() and friends would clash with
+// the definitions below
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeGuard.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// the allocator behind malloc(), which glibc exports under these names
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+const unsigned kMaxReports = 32;
+const int kMaxFrames = 32;
+
+std::atomic<uint64_t> gViolations {0};
+std::atomic<unsigned> gReports {0};
+std::atomic<bool> gReporting {true};
+
+thread_local const char* tScope = nullptr;
+thread_local unsigned tDepth = 0;
+thread_local bool tReporting = false;
+
+// bypasses the write() below
+void print(const char* text) {
+    syscall(SYS_write, 2, text, strlen(text));
+}
+
+void violation(const char* call) {
+    if (!tScope || tReporting)
+        return;
+
+    // whatever the report itself calls is not flagged
+    tReporting = true;
+    gViolations.fetch_add(1, std::memory_order_relaxed);
+
+    if (gReporting.load(std::memory_order_relaxed)) {
+        const unsigned report = gReports.fetch_add(1, std::memory_order_relaxed);
+        if (report < kMaxReports) {
+            char line[256];
+            snprintf(line, sizeof(line), "realtime violation: %s in %s\n", call, tScope);
+            print(line);
+            void* frames[kMaxFrames];
+            const int count = backtrace(frames, kMaxFrames);
+            backtrace_symbols_fd(frames + 1, count - 1, 2);
+            print("\n");
+        } else if (report == kMaxReports) {
+            print("realtime violation: more violations are counted, not shown\n");
+        }
+    }
+
+    tReporting = false;
+}
+
+/**
+  The next definition of a function, in the C library. The slot has no
+  guard variable: a guard could take a lock, which is intercepted too.
+*/
+void* resolve(std::atomic<void*>& slot, const char* name) {
+    void* function = slot.load(std::memory_order_relaxed);
+    if (!function) {
+        function = dlsym(RTLD_NEXT, name);
+        slot.store(function, std::memory_order_relaxed);
+    }
+    return function;
+}
+
+// backtrace() loads libgcc on its first use, which allocates
+struct Warmup {
+    Warmup() {
+        void* frames[1];
+        backtrace(frames, 1);
+    }
+} gWarmup;
+
+}
+
+namespace RealtimeGuard {
+
+uint64_t getViolationCount() {
+    return gViolations.load(std::memory_order_relaxed);
+}
+
+void resetViolationCount() {
+    gViolations.store(0, std::memory_order_relaxed);
+    gReports.store(0, std::memory_order_relaxed);
+}
+
+void setReporting(bool enabled) {
+    gReporting.store(enabled, std::memory_order_relaxed);
+}
+
+const char* getCurrentScope() {
+    return tScope;
+}
+
+void enterScope(const char* name) {
+    if (tDepth++ == 0)
+        tScope = name;
+}
+
+void leaveScope() {
+    if (--tDepth == 0)
+        tScope = nullptr;
+}
+
+}
+
+// -----------------------------------------------------------------------
+// Memory allocation
+
+extern "C" void* malloc(size_t size) noexcept {
+    violation("malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+    violation("calloc");
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) noexcept {
+    violation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) noexcept {
+    if (ptr)
+        violation("free");
+    __libc_free(ptr);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) noexcept {
+    violation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    violation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    violation("posix_memalign");
+    *result = __libc_memalign(alignment, size);
+    return *result ? 0 : ENOMEM;
+}
+
+static void* allocate(const char* call, size_t size, size_t alignment = 0) {
+    violation(call);
+    void* ptr = alignment ? __libc_memalign(alignment, size) : __libc_malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+static void deallocate(const char* call, void* ptr) noexcept {
+    if (ptr)
+        violation(call);
+    __libc_free(ptr);
+}
+
+void* operator new(size_t size) { return allocate("operator new", size); }
+void* operator new[](size_t size) { return allocate("operator new[]", size); }
+void* operator new(size_t size, std::align_val_t al) { return allocate("operator new", size, (size_t)al); }
+void* operator new[](size_t size, std::align_val_t al) { return allocate("operator new[]", size, (size_t)al); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    violation("operator new");
+    return __libc_malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    violation("operator new[]");
+    return __libc_malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept { deallocate("operator delete", ptr); }
+void operator delete[](void* ptr) noexcept { deallocate("operator delete[]", ptr); }
+void operator delete(void* ptr, size_t) noexcept { deallocate("operator delete", ptr); }
+void operator delete[](void* ptr, size_t) noexcept { deallocate("operator delete[]", ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { deallocate("operator delete", ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { deallocate("operator delete[]", ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { deallocate("operator delete", ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { deallocate("operator delete[]", ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { deallocate("operator delete", ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { deallocate("operator delete[]", ptr); }
+
+// -----------------------------------------------------------------------
+// Locks, waits and blocking system calls, forwarded to the C library
+
+#define INTERCEPT(spec, ret, name, params, args)                          \
+    static std::atomic<void*> real_##name {nullptr};                     \
+    extern "C" ret name params spec {                                    \
+        violation(#name);                                                \
+        return ((ret (*) params)resolve(real_##name, #name)) args;       \
+    }
+
+INTERCEPT(noexcept, int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex))
+INTERCEPT(noexcept, int, pthread_mutex_trylock, (pthread_mutex_t* mutex), (mutex))
+INTERCEPT(noexcept, int, pthread_mutex_unlock, (pthread_mutex_t* mutex), (mutex))
+INTERCEPT(noexcept, int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock))
+INTERCEPT(noexcept, int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock))
+INTERCEPT(, int, pthread_cond_wait, (pthread_cond_t* cond, pthread_mutex_t* mutex), (cond, mutex))
+INTERCEPT(, int, pthread_cond_timedwait,
+          (pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* time), (cond, mutex, time))
+INTERCEPT(, int, pthread_join, (pthread_t thread, void** result), (thread, result))
+INTERCEPT(, int, sem_wait, (sem_t* sem), (sem))
+INTERCEPT(, ssize_t, read, (int fd, void* buffer, size_t count), (fd, buffer, count))
+INTERCEPT(, ssize_t, write, (int fd, const void* buffer, size_t count), (fd, buffer, count))
+INTERCEPT(, int, close, (int fd), (fd))
+INTERCEPT(, int, fsync, (int fd), (fd))
+INTERCEPT(, int, nanosleep, (const struct timespec* time, struct timespec* remaining), (time, remaining))
+INTERCEPT(, int, usleep, (useconds_t time), (time))
+INTERCEPT(, int, poll, (struct pollfd* fds, nfds_t count, int timeout), (fds, count, timeout))
+INTERCEPT(, int, select, (int count, fd_set* readfds, fd_set* writefds, fd_set* exceptfds, struct timeval* timeout),
+          (count, readfds, writefds, exceptfds, timeout))
+INTERCEPT(noexcept, void*, mmap, (void* address, size_t length, int protection, int flags, int fd, off_t offset),
+          (address, length, protection, flags, fd, offset))
+INTERCEPT(noexcept, int, munmap, (void* address, size_t length), (address, length))
+
+static std::atomic<void*> real_open {nullptr};
+
+extern "C" int open(const char* path, int flags, ...) {
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+    violation("open");
+    return ((int (*)(const char*, int, ...))resolve(real_open, "open"))(path, flags, mode);
+}
@@ -0,0 +1,74 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef REALTIME_GUARD_H
+#define REALTIME_GUARD_H
+
+#include <cstdint>
+
+// -----------------------------------------------------------------------
+
+/**
+  Detection of calls which are not realtime-safe.
+
+  Linked into a program, RealtimeGuard.cpp replaces malloc, free, operator
+  new and delete, the pthread locking and waiting functions, and the
+  common blocking system calls. While the calling thread is inside a
+  RealtimeScope, each of these calls is reported on stderr with a stack
+  trace, and counted. Linux and glibc only.
+*/
+namespace RealtimeGuard {
+
+// number of calls flagged so far, in all threads
+uint64_t getViolationCount();
+void resetViolationCount();
+
+// set whether violations are printed, they are counted in any case
+void setReporting(bool enabled);
+
+// name of the scope the calling thread is in, or null
+const char* getCurrentScope();
+void enterScope(const char* name);
+void leaveScope();
+
+}
+
+/**
+  Marks a realtime section, such as a call to run(), for the calling thread.
+*/
+class RealtimeScope {
+public:
+    explicit RealtimeScope(const char* name) { RealtimeGuard::enterScope(name); }
+    ~RealtimeScope() { RealtimeGuard::leaveScope(); }
+
+private:
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef REALTIME_GUARD_H
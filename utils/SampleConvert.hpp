@@ -0,0 +1,209 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+#include "WavFile.hpp"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+// -----------------------------------------------------------------------
+// Conversion between WAV sample data and float, SSE2 for the common cases
+
+inline int32_t readSample24(const uint8_t* p) {
+    return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+}
+
+/**
+  Decode interleaved WAV samples to interleaved float.
+*/
+inline void decodeSamples(const WavFormat& format, const uint8_t* in, float* out, size_t count) {
+    size_t i = 0;
+
+    if (format.isFloat) {
+        memcpy(out, in, count * sizeof(float));
+        return;
+    }
+
+    switch (format.bitsPerSample) {
+    case 16: {
+        const int16_t* src = (const int16_t*)in;
+        const float scale = 1.0f / 32768.0f;
+#if defined(__SSE2__)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+            // sign-extend to 32 bits by placing each sample in the high half
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+        }
+#endif
+        for (; i < count; ++i)
+            out[i] = src[i] * scale;
+        break;
+    }
+    case 24: {
+        const float scale = 1.0f / 8388608.0f;
+        for (; i < count; ++i)
+            out[i] = readSample24(in + 3 * i) * scale;
+        break;
+    }
+    case 32: {
+        const int32_t* src = (const int32_t*)in;
+        const float scale = 1.0f / 2147483648.0f;
+#if defined(__SSE2__)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), vscale));
+        }
+#endif
+        for (; i < count; ++i)
+            out[i] = src[i] * scale;
+        break;
+    }
+    }
+}
+
+/**
+  Encode interleaved float to WAV samples, with rounding and clipping.
+*/
+inline void encodeSamples(const WavFormat& format, const float* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+
+    if (format.isFloat) {
+        memcpy(out, in, count * sizeof(float));
+        return;
+    }
+
+    switch (format.bitsPerSample) {
+    case 16: {
+        int16_t* dst = (int16_t*)out;
+#if defined(__SSE2__)
+        const __m128 vscale = _mm_set1_ps(32768.0f);
+        const __m128 vmin = _mm_set1_ps(-32768.0f);
+        const __m128 vmax = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8) {
+            // clamp first so that out-of-range values keep their sign
+            const __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), vscale);
+            const __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale);
+            const __m128i lo = _mm_cvtps_epi32(_mm_max_ps(vmin, _mm_min_ps(vmax, a)));
+            const __m128i hi = _mm_cvtps_epi32(_mm_max_ps(vmin, _mm_min_ps(vmax, b)));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(lo, hi));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = (int16_t)lrintf(fmaxf(-32768.0f, fminf(32767.0f, in[i] * 32768.0f)));
+        break;
+    }
+    case 24: {
+        for (; i < count; ++i) {
+            const int32_t x = (int32_t)lrintf(fmaxf(-8388608.0f, fminf(8388607.0f, in[i] * 8388608.0f)));
+            out[3 * i] = (uint8_t)x;
+            out[3 * i + 1] = (uint8_t)(x >> 8);
+            out[3 * i + 2] = (uint8_t)(x >> 16);
+        }
+        break;
+    }
+    case 32: {
+        int32_t* dst = (int32_t*)out;
+        // largest float below 2^31
+        const float maxValue = 2147483520.0f;
+        for (; i < count; ++i)
+            dst[i] = (int32_t)lrintf(fmaxf(-2147483648.0f, fminf(maxValue, in[i] * 2147483648.0f)));
+        break;
+    }
+    }
+}
+
+/**
+  Split interleaved float frames into one buffer per channel.
+*/
+inline void deinterleave(const float* in, float* const* out, uint32_t channels, uint32_t frames) {
+    uint32_t i = 0;
+
+    if (channels == 2) {
+        float* outL = out[0];
+        float* outR = out[1];
+#if defined(__SSE2__)
+        for (; i + 4 <= frames; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + 2 * i);      // L0 R0 L1 R1
+            const __m128 b = _mm_loadu_ps(in + 2 * i + 4);  // L2 R2 L3 R3
+            _mm_storeu_ps(outL + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(outR + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#endif
+        for (; i < frames; ++i) {
+            outL[i] = in[2 * i];
+            outR[i] = in[2 * i + 1];
+        }
+        return;
+    }
+
+    for (uint32_t c = 0; c < channels; ++c)
+        for (i = 0; i < frames; ++i)
+            out[c][i] = in[i * channels + c];
+}
+
+/**
+  Merge one buffer per channel into interleaved float frames.
+*/
+inline void interleave(const float* const* in, float* out, uint32_t channels, uint32_t frames) {
+    uint32_t i = 0;
+
+    if (channels == 2) {
+        const float* inL = in[0];
+        const float* inR = in[1];
+#if defined(__SSE2__)
+        for (; i + 4 <= frames; i += 4) {
+            const __m128 l = _mm_loadu_ps(inL + i);
+            const __m128 r = _mm_loadu_ps(inR + i);
+            _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+#endif
+        for (; i < frames; ++i) {
+            out[2 * i] = inL[i];
+            out[2 * i + 1] = inR[i];
+        }
+        return;
+    }
+
+    for (uint32_t c = 0; c < channels; ++c)
+        for (i = 0; i < frames; ++i)
+            out[i * channels + c] = in[c][i];
+}
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef SAMPLE_CONVERT_H
@@ -0,0 +1,248 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "WavFile.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+const uint16_t kFormatPCM = 1;
+const uint16_t kFormatFloat = 3;
+const uint16_t kFormatExtensible = 0xfffe;
+
+// size of the header written by WavWriter
+const uint64_t kWriterHeaderSize = 44;
+
+inline uint16_t readLE16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t readLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void writeLE16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void writeLE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------
+// WavReader
+
+bool WavReader::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return fail("cannot open file");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        ::close(fd);
+        return fail("cannot read file");
+    }
+
+    mappingSize = (size_t)st.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        return fail("cannot map file");
+    }
+
+    // the file is read front to back exactly once
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    const uint8_t* bytes = (const uint8_t*)mapping;
+    if (memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0)
+        return fail("not a WAV file");
+
+    bool haveFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= mappingSize) {
+        const uint8_t* chunk = bytes + offset;
+        const size_t chunkSize = readLE32(chunk + 4);
+        const size_t available = mappingSize - (offset + 8);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || chunkSize > available)
+                return fail("invalid format chunk");
+            uint16_t tag = readLE16(chunk + 8);
+            format.channels = readLE16(chunk + 10);
+            format.sampleRate = readLE32(chunk + 12);
+            format.bitsPerSample = readLE16(chunk + 22);
+            if (tag == kFormatExtensible && chunkSize >= 40)
+                tag = readLE16(chunk + 32);  // first two bytes of the subformat GUID
+            if (tag != kFormatPCM && tag != kFormatFloat)
+                return fail("unsupported sample format");
+            format.isFloat = tag == kFormatFloat;
+            if (format.isFloat ? (format.bitsPerSample != 32)
+                               : (format.bitsPerSample != 16 && format.bitsPerSample != 24 && format.bitsPerSample != 32))
+                return fail("unsupported bit depth");
+            if (format.channels == 0)
+                return fail("invalid channel count");
+            haveFormat = true;
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat)
+                return fail("data before format chunk");
+            // tolerate truncated files and streaming writers which leave the size unset
+            const size_t dataSize = (chunkSize > available) ? available : chunkSize;
+            data = chunk + 8;
+            frameCount = dataSize / format.bytesPerFrame();
+            return true;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    return fail("no data chunk");
+}
+
+void WavReader::close() {
+    if (mapping)
+        munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    data = nullptr;
+    frameCount = 0;
+    format = WavFormat();
+}
+
+bool WavReader::fail(const char* message) {
+    error = message;
+    close();
+    return false;
+}
+
+// -----------------------------------------------------------------------
+// WavWriter
+
+bool WavWriter::open(const char* path, const WavFormat& fmt) {
+    close();
+
+    format = fmt;
+    dataBytes = 0;
+
+    file = fopen(path, "wb");
+    if (!file)
+        return fail("cannot create file");
+
+    // large stdio buffer, the data comes in big blocks anyway
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    if (!writeHeader(0))
+        return fail("write error");
+    return true;
+}
+
+bool WavWriter::write(const void* frames, uint32_t count) {
+    const size_t bytes = (size_t)count * format.bytesPerFrame();
+    if (fwrite(frames, 1, bytes, file) != bytes)
+        return fail("write error");
+    dataBytes += bytes;
+    return true;
+}
+
+bool WavWriter::reserve(uint64_t frameCount) {
+    dataBytes = frameCount * format.bytesPerFrame();
+    if (fflush(file) != 0 || ftruncate(fileno(file), (off_t)(kWriterHeaderSize + dataBytes)) != 0)
+        return fail("cannot reserve space");
+    return true;
+}
+
+bool WavWriter::writeAt(uint64_t frame, const void* frames, uint32_t count) const {
+    const size_t bytes = (size_t)count * format.bytesPerFrame();
+    off_t offset = (off_t)(kWriterHeaderSize + frame * format.bytesPerFrame());
+    const uint8_t* data = (const uint8_t*)frames;
+    for (size_t done = 0; done < bytes;) {
+        const ssize_t written = pwrite(fileno(file), data + done, bytes - done, offset + done);
+        if (written <= 0)
+            return false;
+        done += (size_t)written;
+    }
+    return true;
+}
+
+bool WavWriter::close() {
+    if (!file)
+        return true;
+
+    bool ok = true;
+    if (dataBytes & 1)
+        ok = fseek(file, (long)(kWriterHeaderSize + dataBytes), SEEK_SET) == 0 && fputc(0, file) != EOF;
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && writeHeader(dataBytes);
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+
+    if (!ok)
+        error = "cannot finalize file";
+    return ok;
+}
+
+bool WavWriter::fail(const char* message) {
+    error = message;
+    if (file)
+        fclose(file);
+    file = nullptr;
+    return false;
+}
+
+bool WavWriter::writeHeader(uint64_t size) {
+    // RIFF sizes are 32-bit; saturate for files beyond 4 GiB
+    const uint32_t dataSize = (size > 0xffffffffu - 36) ? (0xffffffffu - 36) : (uint32_t)size;
+
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    writeLE32(header + 4, 36 + dataSize + (dataSize & 1));
+    memcpy(header + 8, "WAVEfmt ", 8);
+    writeLE32(header + 16, 16);
+    writeLE16(header + 20, format.isFloat ? kFormatFloat : kFormatPCM);
+    writeLE16(header + 22, format.channels);
+    writeLE32(header + 24, format.sampleRate);
+    writeLE32(header + 28, format.sampleRate * format.bytesPerFrame());
+    writeLE16(header + 32, (uint16_t)format.bytesPerFrame());
+    writeLE16(header + 34, format.bitsPerSample);
+    memcpy(header + 36, "data", 4);
+    writeLE32(header + 40, dataSize);
+
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
@@ -0,0 +1,115 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// -----------------------------------------------------------------------
+
+struct WavFormat {
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;  // 16, 24 or 32
+    bool isFloat = false;        // 32-bit IEEE float
+
+    uint32_t bytesPerFrame() const { return channels * (bitsPerSample / 8); }
+};
+
+/**
+  Read-only WAV file mapped into memory.
+  Supports PCM 16, 24, 32 bit and 32-bit float, plain or extensible.
+*/
+class WavReader {
+public:
+    WavReader() {}
+    ~WavReader() { close(); }
+
+    bool open(const char* path);
+    void close();
+
+    const std::string& getError() const { return error; }
+    const WavFormat& getFormat() const { return format; }
+    uint64_t getFrameCount() const { return frameCount; }
+
+    // Interleaved sample data of the frame at the given index
+    const uint8_t* getFrameData(uint64_t frame) const {
+        return data + frame * format.bytesPerFrame();
+    }
+
+private:
+    bool fail(const char* message);
+
+    std::string error;
+    WavFormat format;
+    uint64_t frameCount = 0;
+    const uint8_t* data = nullptr;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+};
+
+/**
+  WAV file writer. The sizes in the header are patched on close().
+
+  The data is either written sequentially with write(), or, by several
+  threads filling one file, with writeAt() after reserve() has set its size.
+*/
+class WavWriter {
+public:
+    WavWriter() {}
+    ~WavWriter() { close(); }
+
+    bool open(const char* path, const WavFormat& format);
+    bool write(const void* frames, uint32_t count);
+    bool reserve(uint64_t frameCount);
+    bool writeAt(uint64_t frame, const void* frames, uint32_t count) const;
+    bool close();
+
+    const std::string& getError() const { return error; }
+
+private:
+    bool fail(const char* message);
+    bool writeHeader(uint64_t dataBytes);
+
+    std::string error;
+    WavFormat format;
+    FILE* file = nullptr;
+    uint64_t dataBytes = 0;
+
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef WAV_FILE_H
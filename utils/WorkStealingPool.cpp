@@ -0,0 +1,226 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "WorkStealingPool.hpp"
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+// -----------------------------------------------------------------------
+// WorkStealingDeque
+
+static uint32_t nextPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+WorkStealingDeque::WorkStealingDeque(uint32_t capacity)
+    : fBuffer(new std::atomic<uint32_t>[nextPowerOfTwo(capacity)]),
+      fMask(nextPowerOfTwo(capacity) - 1)
+{
+}
+
+bool WorkStealingDeque::push(uint32_t task) {
+    const int64_t b = fBottom.load(std::memory_order_relaxed);
+    const int64_t t = fTop.load(std::memory_order_acquire);
+    if (b - t > fMask)
+        return false;
+    fBuffer[b & fMask].store(task, std::memory_order_relaxed);
+    // a release store rather than the fence of the paper, same code on
+    // x86, and it makes whatever the task reads visible to a thief in a
+    // way ThreadSanitizer understands
+    fBottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+bool WorkStealingDeque::pop(uint32_t& task) {
+    const int64_t b = fBottom.load(std::memory_order_relaxed) - 1;
+    fBottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = fTop.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // empty
+        fBottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    task = fBuffer[b & fMask].load(std::memory_order_relaxed);
+    if (t == b) {
+        // last one, race against the thieves
+        const bool won = fTop.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        fBottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool WorkStealingDeque::steal(uint32_t& task) {
+    int64_t t = fTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = fBottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return false;
+
+    task = fBuffer[t & fMask].load(std::memory_order_relaxed);
+    return fTop.compare_exchange_strong(
+        t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------
+// WorkStealingPool
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount, uint32_t queueCapacity)
+    : fQueueCapacity(queueCapacity)
+{
+    if (threadCount < 1)
+        threadCount = 1;
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        fWorkers.emplace_back(new Worker(queueCapacity));
+        fWorkers.back()->random = 0x9e3779b9u * (i + 1);
+    }
+    for (unsigned i = 0; i < threadCount; ++i)
+        fWorkers[i]->thread = std::thread(&WorkStealingPool::threadMain, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fQuit = true;
+    }
+    fStartCondition.notify_all();
+    for (std::unique_ptr<Worker>& worker : fWorkers)
+        worker->thread.join();
+}
+
+bool WorkStealingPool::start(const uint32_t* initial, uint32_t initialCount, uint32_t taskCount,
+                             TaskFunction function, void* context) {
+    const unsigned threadCount = getThreadCount();
+    if ((initialCount + threadCount - 1) / threadCount > fQueueCapacity)
+        return false;
+
+    std::unique_lock<std::mutex> lock(fMutex);
+
+    // the workers are idle, so the deques can be filled from here
+    for (uint32_t i = 0; i < initialCount; ++i)
+        fWorkers[i % threadCount]->deque.push(initial[i]);
+
+    fFunction = function;
+    fContext = context;
+    fRemaining.store(taskCount, std::memory_order_relaxed);
+    fRunning = threadCount;
+    ++fGeneration;
+
+    lock.unlock();
+    fStartCondition.notify_all();
+    return true;
+}
+
+bool WorkStealingPool::waitFor(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(fMutex);
+    return fDoneCondition.wait_for(lock, timeout, [this] { return fRunning == 0; });
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    fDoneCondition.wait(lock, [this] { return fRunning == 0; });
+}
+
+void WorkStealingPool::spawn(unsigned worker, uint32_t task) {
+    if (!fWorkers[worker]->deque.push(task)) {
+        fFunction(fContext, task, worker);
+        fRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void WorkStealingPool::threadMain(unsigned index) {
+    uint64_t generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            fStartCondition.wait(lock, [&] { return fQuit || fGeneration != generation; });
+            if (fQuit)
+                return;
+            generation = fGeneration;
+        }
+
+        workLoop(index);
+
+        std::lock_guard<std::mutex> lock(fMutex);
+        if (--fRunning == 0)
+            fDoneCondition.notify_all();
+    }
+}
+
+void WorkStealingPool::workLoop(unsigned index) {
+    unsigned idle = 0;
+
+    while (fRemaining.load(std::memory_order_acquire) > 0) {
+        uint32_t task;
+        if (findTask(index, task)) {
+            fFunction(fContext, task, index);
+            fRemaining.fetch_sub(1, std::memory_order_acq_rel);
+            idle = 0;
+        }
+        else if (++idle < 64) {
+#if defined(__SSE2__)
+            _mm_pause();
+#endif
+        }
+        else if (idle < 1024) {
+            std::this_thread::yield();
+        }
+        else {
+            // long tasks elsewhere, no need to keep a core busy
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+bool WorkStealingPool::findTask(unsigned index, uint32_t& task) {
+    Worker& self = *fWorkers[index];
+    if (self.deque.pop(task))
+        return true;
+
+    // try the others, starting from a random victim
+    const unsigned threadCount = getThreadCount();
+    self.random ^= self.random << 13;
+    self.random ^= self.random >> 17;
+    self.random ^= self.random << 5;
+    const unsigned first = self.random % threadCount;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        const unsigned victim = (first + i) % threadCount;
+        if (victim != index && fWorkers[victim]->deque.steal(task))
+            return true;
+    }
+    return false;
+}
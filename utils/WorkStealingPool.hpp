@@ -0,0 +1,144 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+/**
+  Fixed-capacity Chase-Lev work-stealing deque of task indices.
+
+  The owner pushes and pops at the bottom; other threads steal from the top.
+  Lê, Pop, Cohen, Zappa Nardelli, "Correct and efficient work-stealing for
+  weak memory models", PPoPP 2013
+*/
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(uint32_t capacity);
+
+    // owner only; fails when the deque is full
+    bool push(uint32_t task);
+    // owner only
+    bool pop(uint32_t& task);
+    // any thread
+    bool steal(uint32_t& task);
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> fBuffer;
+    const int64_t fMask;
+    alignas(64) std::atomic<int64_t> fTop {0};
+    alignas(64) std::atomic<int64_t> fBottom {0};
+};
+
+/**
+  Pool of worker threads, each with its own work-stealing deque.
+
+  A job is a number of tasks identified by indices. The initial tasks are
+  spread over the deques, a task may spawn more tasks on its worker's
+  deque, and idle workers steal from the others. The job ends when the
+  announced number of tasks has run.
+*/
+class WorkStealingPool {
+public:
+    typedef void (*TaskFunction)(void* context, uint32_t task, unsigned worker);
+
+    WorkStealingPool(unsigned threadCount, uint32_t queueCapacity);
+    ~WorkStealingPool();
+
+    unsigned getThreadCount() const { return (unsigned)fWorkers.size(); }
+
+    /**
+      Start a job of taskCount tasks in total, beginning with the initial
+      ones, which are dealt round-robin starting with worker 0. Since the
+      owner of a deque takes its newest task first and thieves take the
+      oldest, the last task dealt to a worker is the first it runs.
+      Returns false if the initial tasks do not fit in the deques.
+    */
+    bool start(const uint32_t* initial, uint32_t initialCount, uint32_t taskCount,
+               TaskFunction function, void* context);
+
+    /**
+      Wait for the job to finish, at most for the given time.
+      Returns true if it has finished.
+    */
+    bool waitFor(std::chrono::milliseconds timeout);
+
+    void wait();
+
+    template <class F>
+    void execute(const uint32_t* initial, uint32_t initialCount, uint32_t taskCount, F& function) {
+        if (start(initial, initialCount, taskCount,
+                  [](void* context, uint32_t task, unsigned worker) { (*(F*)context)(task, worker); },
+                  &function))
+            wait();
+    }
+
+    /**
+      Make a task ready, from inside a task running on the given worker.
+      When the deque is full, the task runs immediately.
+    */
+    void spawn(unsigned worker, uint32_t task);
+
+private:
+    struct Worker {
+        explicit Worker(uint32_t capacity) : deque(capacity) {}
+        WorkStealingDeque deque;
+        std::thread thread;
+        uint32_t random = 0;
+    };
+
+    void threadMain(unsigned index);
+    void workLoop(unsigned index);
+    bool findTask(unsigned index, uint32_t& task);
+
+    std::vector<std::unique_ptr<Worker>> fWorkers;
+    uint32_t fQueueCapacity;
+
+    TaskFunction fFunction = nullptr;
+    void* fContext = nullptr;
+    std::atomic<uint32_t> fRemaining {0};
+
+    std::mutex fMutex;
+    std::condition_variable fStartCondition;
+    std::condition_variable fDoneCondition;
+    uint64_t fGeneration = 0;
+    unsigned fRunning = 0;
+    bool fQuit = false;
+};
+
+// -----------------------------------------------------------------------
+
+#endif  // #ifndef WORK_STEALING_POOL_H
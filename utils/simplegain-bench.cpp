@@ -0,0 +1,459 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Benchmark of the DSP kernels.
+
+  The ADAA soft clipper is compared against a naive soft clipper and a
+  4x oversampled tanh, for speed (ns/sample) and aliasing (power of the
+  aliased harmonics of a driven 7 kHz sine, relative to the fundamental).
+  The overhead of the DSP load meter is measured per block. Many smoothed
+  gain stages are run as separate objects, then as the slots of a
+  GainBatch, one by one and four at a time.
+
+  With --counters, hardware performance counters are read around the
+  processing of each kernel, to tell why one is slow: instructions per
+  cycle, and cache and branch misses per 1000 samples.
+*/
+
+#include "ADAAClipper.hpp"
+#include "DspLoadMeter.hpp"
+#include "GainBatch.hpp"
+#include "PerfCounters.hpp"
+#include "TruePeakMeter.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <getopt.h>
+#include <memory>
+#include <set>
+#include <vector>
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const uint32_t kBlockSize = 256;
+const uint32_t kBenchFrames = 1 << 16;
+const unsigned kBenchRepeats = 20;
+
+/**
+  Reference: tanh at 4x the sample rate, with the BS.1770 interpolator as
+  the upsampling and the decimation filter.
+*/
+class OversampledTanh {
+public:
+    enum { kLength = Upsampler4x::kTaps * Upsampler4x::kPhases };
+
+    OversampledTanh() {
+        for (unsigned k = 0; k < Upsampler4x::kTaps; ++k)
+            for (unsigned p = 0; p < Upsampler4x::kPhases; ++p)
+                proto[k * Upsampler4x::kPhases + p] = Upsampler4x::coefs[k][p] * 0.25f;
+        reset();
+    }
+
+    void reset() {
+        up.reset();
+        memset(hist, 0, sizeof(hist));
+        pos = 0;
+    }
+
+    void process(float* io, uint32_t frames) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            float u[Upsampler4x::kPhases];
+            up.process(io[i], u);
+            for (unsigned p = 0; p < Upsampler4x::kPhases; ++p) {
+                hist[pos] = hist[pos + kLength] = tanhf(u[p]);
+                pos = (pos + 1 < kLength) ? (pos + 1) : 0;
+            }
+            // newest sample at hist[pos + kLength - 1]
+            const float* x = &hist[pos];
+            float acc = 0.0f;
+            for (unsigned j = 0; j < kLength; ++j)
+                acc += proto[j] * x[kLength - 1 - j];
+            io[i] = acc;
+        }
+    }
+
+private:
+    Upsampler4x up;
+    float proto[kLength];
+    float hist[2 * kLength];
+    unsigned pos;
+};
+
+struct Kernel {
+    const char* name;
+    void (*reset)();
+    void (*process)(float* io, uint32_t frames);
+};
+
+ADAAClipper gClipper;
+OversampledTanh gOversampled;
+
+const Kernel kKernels[] = {
+    {
+        "softclip-naive",
+        [] {},
+        [](float* io, uint32_t frames) {
+            for (uint32_t i = 0; i < frames; ++i)
+                io[i] = ADAAClipper::clip(io[i]);
+        }
+    },
+    {
+        "softclip-adaa1",
+        [] { gClipper.reset(); },
+        [](float* io, uint32_t frames) { gClipper.process(io, frames); }
+    },
+    {
+        "tanh-oversampled-4x",
+        [] { gOversampled.reset(); },
+        [](float* io, uint32_t frames) { gOversampled.process(io, frames); }
+    },
+};
+
+void generateSine(std::vector<float>& buffer, double frequency, float amplitude) {
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = amplitude * (float)std::sin(2.0 * M_PI * frequency * (double)i / kSampleRate);
+}
+
+void processBlocks(const Kernel& kernel, std::vector<float>& buffer) {
+    for (size_t offset = 0; offset < buffer.size(); offset += kBlockSize) {
+        size_t count = buffer.size() - offset;
+        if (count > kBlockSize)
+            count = kBlockSize;
+        kernel.process(&buffer[offset], (uint32_t)count);
+    }
+}
+
+double goertzelPower(const std::vector<float>& buffer, double frequency) {
+    const double w = 2.0 * M_PI * frequency / kSampleRate;
+    const double c = 2.0 * std::cos(w);
+    double s1 = 0.0, s2 = 0.0;
+    for (float x : buffer) {
+        const double s0 = x + c * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return s1 * s1 + s2 * s2 - c * s1 * s2;
+}
+
+/**
+  Drive a 7 kHz sine into the kernel for one second, and measure the
+  power at the frequencies where its odd harmonics fold back.
+*/
+double measureAliasingDb(const Kernel& kernel) {
+    const double f0 = 7000.0;
+    std::vector<float> buffer((size_t)kSampleRate);
+    generateSine(buffer, f0, 2.0f);
+    kernel.reset();
+    processBlocks(kernel, buffer);
+
+    // below the 45th harmonic, no alias lands on the fundamental or the 3rd
+    std::set<double> aliases;
+    for (unsigned h = 5; h < 45; h += 2) {
+        double f = std::fmod(h * f0, kSampleRate);
+        if (f > 0.5 * kSampleRate)
+            f = kSampleRate - f;
+        aliases.insert(f);
+    }
+
+    double aliasPower = 0.0;
+    for (double f : aliases)
+        aliasPower += goertzelPower(buffer, f);
+    return 10.0 * std::log10(aliasPower / goertzelPower(buffer, f0));
+}
+
+double measureNsPerSample(const Kernel& kernel) {
+    std::vector<float> source(kBenchFrames);
+    std::vector<float> buffer(kBenchFrames);
+    generateSine(source, 997.0, 2.0f);
+
+    double best = HUGE_VAL;
+    for (unsigned r = 0; r < kBenchRepeats; ++r) {
+        buffer = source;
+        kernel.reset();
+        const auto t0 = std::chrono::steady_clock::now();
+        processBlocks(kernel, buffer);
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (ns < best)
+            best = ns;
+    }
+    return best / kBenchFrames;
+}
+
+/**
+  Hardware counters over the same processing as measureNsPerSample(),
+  summed over all the repetitions.
+*/
+void measureCounters(const Kernel& kernel, PerfCounters& counters) {
+    std::vector<float> source(kBenchFrames);
+    std::vector<float> buffer(kBenchFrames);
+    generateSine(source, 997.0, 2.0f);
+
+    uint64_t totals[PerfCounters::kCounterCount] = {};
+    for (unsigned r = 0; r < kBenchRepeats; ++r) {
+        buffer = source;
+        kernel.reset();
+        counters.start();
+        processBlocks(kernel, buffer);
+        counters.stop();
+        for (unsigned c = 0; c < PerfCounters::kCounterCount; ++c)
+            totals[c] += counters.getCount((PerfCounters::Counter)c);
+    }
+
+    const double samples = (double)kBenchFrames * kBenchRepeats;
+    char ipc[16] = "n/a";
+    if (counters.isAvailable(PerfCounters::kCycles) && counters.isAvailable(PerfCounters::kInstructions) &&
+        totals[PerfCounters::kCycles] > 0)
+        snprintf(ipc, sizeof(ipc), "%.2f", (double)totals[PerfCounters::kInstructions] / (double)totals[PerfCounters::kCycles]);
+    printf("%-24s %8s", kernel.name, ipc);
+
+    const PerfCounters::Counter perSample[] = {
+        PerfCounters::kCycles,
+        PerfCounters::kL1DMisses,
+        PerfCounters::kLLCMisses,
+        PerfCounters::kBranchMisses,
+    };
+    for (PerfCounters::Counter counter : perSample) {
+        // cycles per sample, misses per 1000 samples
+        const double scale = (counter == PerfCounters::kCycles) ? 1.0 : 1000.0;
+        if (counters.isAvailable(counter))
+            printf(" %14.3f", (double)totals[counter] * scale / samples);
+        else
+            printf(" %14s", "n/a");
+    }
+    printf("\n");
+}
+
+/**
+  Cost of timing and recording one block, as in PluginSimpleGain::run().
+*/
+double measureLoadMeterNsPerBlock() {
+    const unsigned blocks = 1 << 20;
+    DspLoadMeter meter;
+    meter.setSampleRate(kSampleRate);
+
+    double best = HUGE_VAL;
+    for (unsigned r = 0; r < kBenchRepeats; ++r) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (unsigned b = 0; b < blocks; ++b) {
+            const uint64_t start = DspLoadMeter::now();
+            meter.record(start, kBlockSize);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (ns < best)
+            best = ns;
+    }
+    return best / blocks;
+}
+
+/**
+  Cost of reading the time alone, two of which are in every block.
+*/
+double measureTickReadNs() {
+    const unsigned reads = 1 << 20;
+    uint64_t sum = 0;
+
+    double best = HUGE_VAL;
+    for (unsigned r = 0; r < kBenchRepeats; ++r) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < reads; ++i)
+            sum += DspLoadMeter::now();
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (ns < best)
+            best = ns;
+    }
+    return (sum != 0) ? best / reads : 0.0;
+}
+
+/**
+  Many stereo gain stages, each with its smoother, processed block by block.
+*/
+class GainStageBench {
+public:
+    enum {
+        kStages = 512,
+        kBlocks = 64,
+    };
+
+    GainStageBench()
+        : fBatch(kStages),
+          fInput(2 * kBlockSize),
+          fOutput((size_t)kStages * 2 * kBlockSize)
+    {
+        generateSine(fInput, 997.0, 0.5f);
+        for (unsigned s = 0; s < kStages; ++s) {
+            const int slot = fBatch.acquire();
+            fBatch.setSampleRate((uint32_t)slot, (float)kSampleRate);
+            fTargets[s] = 0.5f + 0.5f * (float)s / kStages;
+            fInputs[2 * s] = &fInput[0];
+            fInputs[2 * s + 1] = &fInput[kBlockSize];
+            fOutputs[2 * s] = &fOutput[(size_t)2 * s * kBlockSize];
+            fOutputs[2 * s + 1] = &fOutput[(size_t)(2 * s + 1) * kBlockSize];
+        }
+    }
+
+    // one CParamSmooth per stage, allocated on its own, as PluginSimpleGain had
+    double measureObjects(std::vector<float>& result) {
+        std::unique_ptr<CParamSmooth> smoothers[kStages];
+        return measure(result,
+            [&] {
+                for (unsigned s = 0; s < kStages; ++s)
+                    smoothers[s].reset(new CParamSmooth(20.0f, (float)kSampleRate));
+            },
+            [&] {
+                for (unsigned s = 0; s < kStages; ++s) {
+                    CParamSmooth& smoother = *smoothers[s];
+                    const float* inL = fInputs[2 * s];
+                    const float* inR = fInputs[2 * s + 1];
+                    float* outL = fOutputs[2 * s];
+                    float* outR = fOutputs[2 * s + 1];
+                    for (uint32_t i = 0; i < kBlockSize; ++i) {
+                        const float gain = smoother.process(fTargets[s]);
+                        outL[i] = inL[i] * gain;
+                        outR[i] = inR[i] * gain;
+                    }
+                }
+            });
+    }
+
+    double measureSlots(std::vector<float>& result) {
+        return measure(result, [&] { resetBatch(); },
+            [&] {
+                for (unsigned s = 0; s < kStages; ++s)
+                    fBatch.processSlot(s, &fInputs[2 * s], &fOutputs[2 * s], kBlockSize);
+            });
+    }
+
+    double measureBatch(std::vector<float>& result) {
+        return measure(result, [&] { resetBatch(); },
+            [&] { fBatch.process(0, kStages, fInputs, fOutputs, kBlockSize); });
+    }
+
+private:
+    void resetBatch() {
+        for (unsigned s = 0; s < kStages; ++s) {
+            fBatch.reset(s);
+            fBatch.setTarget(s, fTargets[s]);
+        }
+    }
+
+    /**
+      Best time per stage and frame, keeping the output of the last block.
+    */
+    template <class Reset, class Process>
+    double measure(std::vector<float>& result, Reset reset, Process process) {
+        double best = HUGE_VAL;
+        for (unsigned r = 0; r < kBenchRepeats; ++r) {
+            reset();
+            const auto t0 = std::chrono::steady_clock::now();
+            for (unsigned b = 0; b < kBlocks; ++b)
+                process();
+            const auto t1 = std::chrono::steady_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            if (ns < best)
+                best = ns;
+        }
+        result = fOutput;
+        return best / ((double)kStages * kBlocks * kBlockSize);
+    }
+
+    GainBatch fBatch;
+    float fTargets[kStages];
+    std::vector<float> fInput;
+    std::vector<float> fOutput;
+    const float* fInputs[2 * kStages];
+    float* fOutputs[2 * kStages];
+};
+
+} // namespace
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    bool useCounters = false;
+
+    static const struct option longOptions[] = {
+        {"counters", no_argument, nullptr, 'c'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "ch", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'c':
+            useCounters = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-c|--counters]\n", argv[0]);
+            return (c == 'h') ? 0 : 1;
+        }
+    }
+
+    printf("%-24s %12s %12s\n", "kernel", "ns/sample", "alias (dB)");
+    for (const Kernel& kernel : kKernels) {
+        const double ns = measureNsPerSample(kernel);
+        const double alias = measureAliasingDb(kernel);
+        printf("%-24s %12.3f %12.1f\n", kernel.name, ns, alias);
+    }
+
+    printf("\n%-24s %12.1f ns/block\n", "dsp-load-meter", measureLoadMeterNsPerBlock());
+    printf("%-24s %12.1f ns/read\n", "  of which tick reads", measureTickReadNs());
+
+    {
+        GainStageBench gains;
+        std::vector<float> objects, slots, batch;
+        printf("\n%u gain stages          %12s\n", (unsigned)GainStageBench::kStages, "ns/stage/frame");
+        printf("%-24s %12.3f\n", "gain-objects", gains.measureObjects(objects));
+        printf("%-24s %12.3f\n", "gain-batch-slots", gains.measureSlots(slots));
+        printf("%-24s %12.3f\n", "gain-batch-simd", gains.measureBatch(batch));
+        if (slots != objects || batch != objects) {
+            fprintf(stderr, "gain-batch: the results differ from CParamSmooth\n");
+            return 1;
+        }
+    }
+
+    if (useCounters) {
+        PerfCounters counters;
+        printf("\n");
+        if (!counters.open()) {
+            printf("hardware counters skipped: %s\n", counters.getError().c_str());
+            return 0;
+        }
+        printf("%-24s %8s %14s %14s %14s %14s\n",
+               "kernel", "IPC", "cycles/sample", "L1D miss/1k", "LLC miss/1k", "br miss/1k");
+        for (const Kernel& kernel : kKernels)
+            measureCounters(kernel, counters);
+    }
+    return 0;
+}
@@ -0,0 +1,668 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Performance regression gate.
+
+  Measures the throughput of PluginSimpleGain::run in each processing mode,
+  the cost of a morph move, the time of a session state save and load and,
+  when built with the ImGui sources, the CPU cost of a UI frame. Each
+  metric is measured several times; the median is the result, and the
+  spread of the runs (scaled median absolute deviation) is its noise.
+
+  simplegain-perf [options]
+
+  With a baseline, a metric regresses when its median exceeds
+
+      baseline * (1 + tolerance) + 3 * sqrt(noise_baseline² + noise²)
+
+  and the exit status is 1. So it is when a metric is measured but not in
+  the baseline, or in the baseline but not measured, as the UI frame is
+  without the ImGui sources, unless --allow-missing is given. The baseline
+  is the JSON written by --output, where the tolerance of each metric may
+  be edited by hand; --update rewrites the values of a baseline and keeps
+  its tolerances. A metric whose value is null in the baseline is declared
+  with its tolerance but not recorded yet: it is reported, not compared,
+  until --update records it on a build which measures it.
+*/
+
+#include "HeadlessPlugin.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#if SIMPLEGAIN_PERF_UI
+# include "SimpleGainPanel.hpp"
+# include <imgui.h>
+#endif
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const uint32_t kBlockSize = 256;
+const uint32_t kRunFrames = 1 << 22;
+const unsigned kUiFrames = 500;
+const double kNoiseFactor = 3.0;
+
+struct Metric {
+    std::string name;
+    std::string unit;
+    double value = 0.0;
+    double noise = 0.0;
+    double tolerance = 0.0;
+    bool recorded = true;  // false for a null value in a baseline
+};
+
+void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "  -r, --repeat N       measure each metric N times (default 11)\n"
+        "  -b, --baseline FILE  compare against a baseline, exit 1 on regression\n"
+        "  -o, --output FILE    write the results as JSON\n"
+        "  -u, --update         with -b, rewrite the baseline with the results\n"
+        "  -m, --allow-missing  with -b, pass when a metric is missing on one side\n"
+        "  -h, --help           show this help\n",
+        program);
+}
+
+/**
+  Median of the runs, and the median absolute deviation scaled to estimate
+  the standard deviation of normal noise.
+*/
+void summarize(std::vector<double> runs, double& median, double& noise) {
+    std::sort(runs.begin(), runs.end());
+    const size_t n = runs.size();
+    median = (n & 1) ? runs[n / 2] : 0.5 * (runs[n / 2 - 1] + runs[n / 2]);
+
+    for (double& run : runs)
+        run = std::fabs(run - median);
+    std::sort(runs.begin(), runs.end());
+    noise = 1.4826 * ((n & 1) ? runs[n / 2] : 0.5 * (runs[n / 2 - 1] + runs[n / 2]));
+}
+
+// -----------------------------------------------------------------------
+// PluginSimpleGain::run
+
+struct RunMode {
+    const char* name;
+    bool saturation;
+    bool limiter;
+};
+
+const RunMode kRunModes[] = {
+    {"plain", false, false},
+    {"saturation", true, false},
+    {"limiter", false, true},
+    {"saturation+limiter", true, true},
+};
+
+Metric measureRun(const RunMode& mode, unsigned repeats) {
+    HeadlessPlugin* plugin = HeadlessPlugin::create(kSampleRate, kBlockSize);
+    plugin->setParameterValue(PluginSimpleGain::paramGain, 6.0f);
+    plugin->setParameterValue(PluginSimpleGain::paramSaturation, mode.saturation ? 1.0f : 0.0f);
+    plugin->setParameterValue(PluginSimpleGain::paramLimiter, mode.limiter ? 1.0f : 0.0f);
+    plugin->activate();
+
+    // noise at -6 dBFS, hot enough for the clipper and the limiter to act
+    std::vector<float> input[2], output[2];
+    uint32_t random = 1;
+    for (unsigned c = 0; c < 2; ++c) {
+        input[c].resize(kBlockSize);
+        output[c].resize(kBlockSize);
+        for (float& sample : input[c]) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            sample = 0.5f * ((float)(int32_t)random / 2147483648.0f);
+        }
+    }
+    const float* inputs[2] = {input[0].data(), input[1].data()};
+    float* outputs[2] = {output[0].data(), output[1].data()};
+
+    std::vector<double> runs;
+    for (unsigned r = 0; r < repeats + 1; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < kRunFrames; frame += kBlockSize)
+            plugin->run(inputs, outputs, kBlockSize);
+        const auto end = std::chrono::steady_clock::now();
+        // the first pass warms up the caches and the branch predictors
+        if (r > 0)
+            runs.push_back(std::chrono::duration<double, std::nano>(end - start).count() / kRunFrames);
+    }
+    delete plugin;
+
+    Metric metric;
+    metric.name = std::string("run.") + mode.name;
+    metric.unit = "ns/frame";
+    metric.tolerance = 0.10;
+    summarize(runs, metric.value, metric.noise);
+    return metric;
+}
+
+// -----------------------------------------------------------------------
+// Morph automation
+
+/**
+  A move of the morph, as automation sets it on every block, between four
+  snapshots which change every program parameter.
+*/
+Metric measureMorph(unsigned repeats) {
+    HeadlessPlugin* plugin = HeadlessPlugin::create(kSampleRate, kBlockSize);
+    const float snapshots[4][PluginSimpleGain::paramMorph] = {
+        {-12.0f, 0.0f, 0.0f, -1.0f},
+        {0.0f, 1.0f, 0.0f, -3.0f},
+        {6.0f, 1.0f, 1.0f, -6.0f},
+        {-90.0f, 0.0f, 1.0f, -1.0f},
+    };
+    for (uint32_t s = 0; s < 4; ++s)
+        plugin->setMorphSnapshot(s, snapshots[s]);
+
+    const unsigned calls = 100000;
+    std::vector<double> runs;
+    for (unsigned r = 0; r < repeats + 1; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < calls; ++i)
+            plugin->setParameterValue(PluginSimpleGain::paramMorph, (float)(i % 1000) * 0.001f);
+        const auto end = std::chrono::steady_clock::now();
+        if (r > 0)
+            runs.push_back(std::chrono::duration<double, std::nano>(end - start).count() / calls);
+    }
+    delete plugin;
+
+    Metric metric;
+    metric.name = "morph.update";
+    metric.unit = "ns/call";
+    metric.tolerance = 0.25;
+    summarize(runs, metric.value, metric.noise);
+    return metric;
+}
+
+// -----------------------------------------------------------------------
+// PluginSimpleGain::getState and setState
+
+/**
+  A session save and load, each with the base64 text which the host
+  stores, in microseconds per call.
+*/
+void measureState(unsigned repeats, std::vector<Metric>& metrics) {
+    HeadlessPlugin* plugin = HeadlessPlugin::create(kSampleRate, kBlockSize);
+    plugin->setParameterValue(PluginSimpleGain::paramGain, -3.5f);
+    plugin->setParameterValue(PluginSimpleGain::paramLimiter, 1.0f);
+
+    // a session with a UI layout, as a host would restore it
+    StateWriter writer;
+    writer.beginField(PluginSimpleGain::kStateUiLayout);
+    writer.writeVarint(800u);
+    writer.writeVarint(520u);
+    writer.endField();
+    const std::vector<uint8_t>& layout = writer.finish();
+    plugin->loadState(layout.data(), layout.size());
+
+    const unsigned calls = 10000;
+    std::string text;
+    std::vector<uint8_t> decoded;
+    std::vector<double> saves, loads;
+    for (unsigned r = 0; r < repeats + 1; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < calls; ++i) {
+            const std::vector<uint8_t> state = plugin->saveState();
+            text = encodeBase64(state.data(), state.size());
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (r > 0)
+            saves.push_back(std::chrono::duration<double, std::micro>(end - start).count() / calls);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < calls; ++i) {
+            if (!decodeBase64(text.c_str(), decoded) || !plugin->loadState(decoded.data(), decoded.size())) {
+                fprintf(stderr, "The saved state does not load back\n");
+                exit(1);
+            }
+        }
+        end = std::chrono::steady_clock::now();
+        if (r > 0)
+            loads.push_back(std::chrono::duration<double, std::micro>(end - start).count() / calls);
+    }
+    delete plugin;
+
+    Metric metric;
+    metric.unit = "us/call";
+    metric.tolerance = 0.25;
+    metric.name = "state.save";
+    summarize(saves, metric.value, metric.noise);
+    metrics.push_back(metric);
+    metric.name = "state.load";
+    summarize(loads, metric.value, metric.noise);
+    metrics.push_back(metric);
+}
+
+// -----------------------------------------------------------------------
+// ImGuiUI::onDisplay
+
+#if SIMPLEGAIN_PERF_UI
+class NullListener : public SimpleGainPanel::Listener {
+public:
+    void panelEditParameter(uint32_t, bool) override {}
+    void panelSetParameterValue(uint32_t, float) override {}
+    void panelSetSessionState(const std::vector<uint8_t>&) override {}
+};
+
+/**
+  The CPU side of a UI frame: the ImGui frame, the widgets and the
+  building of the draw lists, as in ImGuiUI::onDisplay. The GL submission
+  needs a context, and is left out.
+*/
+Metric measureUiFrame(unsigned repeats) {
+    ImGuiContext* context = ImGui::CreateContext();
+    ImGui::SetCurrentContext(context);
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(600.0f, 400.0f);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    NullListener listener;
+    SimpleGainPanel panel(&listener);
+
+    std::vector<double> runs;
+    for (unsigned r = 0; r < repeats + 1; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned frame = 0; frame < kUiFrames; ++frame) {
+            // the meters move on every frame, as they do while playing
+            const float level = -60.0f + (float)(frame % 60);
+            panel.setParameterValue(PluginSimpleGain::paramTruePeakLeft, level);
+            panel.setParameterValue(PluginSimpleGain::paramTruePeakRight, level - 3.0f);
+
+            ImGui::NewFrame();
+            panel.draw(io.DisplaySize.x, io.DisplaySize.y);
+            ImGui::Render();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        if (r > 0)
+            runs.push_back(std::chrono::duration<double, std::micro>(end - start).count() / kUiFrames);
+    }
+    ImGui::DestroyContext(context);
+
+    Metric metric;
+    metric.name = "ui.frame";
+    metric.unit = "us/frame";
+    metric.tolerance = 0.15;
+    summarize(runs, metric.value, metric.noise);
+    return metric;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// Results
+
+bool writeResults(const char* path, const std::vector<Metric>& metrics) {
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+    fprintf(file, "{\n  \"metrics\": {");
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const Metric& metric = metrics[i];
+        if (!metric.recorded) {
+            fprintf(file, "%s\n    \"%s\": {\"value\": null, \"noise\": null, \"tolerance\": %.3g, \"unit\": \"%s\"}",
+                    i ? "," : "", metric.name.c_str(), metric.tolerance, metric.unit.c_str());
+            continue;
+        }
+        fprintf(file, "%s\n    \"%s\": {\"value\": %.6g, \"noise\": %.6g, \"tolerance\": %.3g, \"unit\": \"%s\"}",
+                i ? "," : "", metric.name.c_str(), metric.value, metric.noise, metric.tolerance, metric.unit.c_str());
+    }
+    fprintf(file, "\n  }\n}\n");
+    return fclose(file) == 0;
+}
+
+/**
+  Reader for the JSON written above: objects, strings and numbers. Reads
+  the members of "metrics" into a map by name.
+*/
+class BaselineReader {
+public:
+    explicit BaselineReader(const std::string& text) : s(text) {}
+
+    bool read(std::map<std::string, Metric>& metrics) {
+        if (!accept('{'))
+            return false;
+        do {
+            std::string key;
+            if (!readString(key) || !accept(':'))
+                return false;
+            if (key == "metrics") {
+                if (!readMetrics(metrics))
+                    return false;
+            }
+            else if (!skipValue()) {
+                return false;
+            }
+        } while (accept(','));
+        return accept('}');
+    }
+
+private:
+    bool readMetrics(std::map<std::string, Metric>& metrics) {
+        if (!accept('{'))
+            return false;
+        if (accept('}'))
+            return true;
+        do {
+            Metric metric;
+            if (!readString(metric.name) || !accept(':') || !accept('{'))
+                return false;
+            do {
+                std::string key;
+                if (!readString(key) || !accept(':'))
+                    return false;
+                bool ok;
+                if (key == "value")
+                    ok = readNull(metric.recorded) || readNumber(metric.value);
+                else if (key == "noise")
+                    ok = readNull(metric.recorded) || readNumber(metric.noise);
+                else if (key == "tolerance")
+                    ok = readNumber(metric.tolerance);
+                else if (key == "unit")
+                    ok = readString(metric.unit);
+                else
+                    ok = skipValue();
+                if (!ok)
+                    return false;
+            } while (accept(','));
+            if (!accept('}'))
+                return false;
+            metrics[metric.name] = metric;
+        } while (accept(','));
+        return accept('}');
+    }
+
+    void skipSpace() {
+        while (i < s.size() && strchr(" \t\r\n", s[i]))
+            ++i;
+    }
+
+    bool accept(char c) {
+        skipSpace();
+        if (i < s.size() && s[i] == c) {
+            ++i;
+            return true;
+        }
+        return false;
+    }
+
+    bool readString(std::string& value) {
+        if (!accept('"'))
+            return false;
+        const size_t end = s.find('"', i);
+        if (end == std::string::npos)
+            return false;
+        value = s.substr(i, end - i);
+        i = end + 1;
+        return true;
+    }
+
+    bool readNumber(double& value) {
+        skipSpace();
+        char* end;
+        value = strtod(s.c_str() + i, &end);
+        if (end == s.c_str() + i)
+            return false;
+        i = end - s.c_str();
+        return true;
+    }
+
+    // null, for a value not recorded yet
+    bool readNull(bool& recorded) {
+        skipSpace();
+        if (s.compare(i, 4, "null") != 0)
+            return false;
+        i += 4;
+        recorded = false;
+        return true;
+    }
+
+    bool skipValue() {
+        skipSpace();
+        if (i >= s.size())
+            return false;
+        if (s[i] == '"') {
+            std::string ignored;
+            return readString(ignored);
+        }
+        if (s[i] == '{') {
+            ++i;
+            if (accept('}'))
+                return true;
+            do {
+                std::string ignored;
+                if (!readString(ignored) || !accept(':') || !skipValue())
+                    return false;
+            } while (accept(','));
+            return accept('}');
+        }
+        bool recorded;
+        double ignored;
+        return readNull(recorded) || readNumber(ignored);
+    }
+
+    const std::string& s;
+    size_t i = 0;
+};
+
+bool readBaseline(const char* path, std::map<std::string, Metric>& metrics) {
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+    std::string text;
+    char buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, count);
+    fclose(file);
+    return BaselineReader(text).read(metrics);
+}
+
+/**
+  Print the comparison, and return the number of regressions; the metrics
+  missing on either side are counted in @a missing, those declared in the
+  baseline but not recorded in @a pending.
+*/
+unsigned compare(std::vector<Metric>& metrics, const std::map<std::string, Metric>& baseline,
+                 unsigned& missing, unsigned& pending) {
+    unsigned regressions = 0;
+    missing = 0;
+    pending = 0;
+    printf("%-26s %12s %12s %10s %12s  %s\n", "metric", "baseline", "current", "noise", "limit", "result");
+
+    for (Metric& metric : metrics) {
+        const auto it = baseline.find(metric.name);
+        if (it == baseline.end()) {
+            printf("%-26s %12s %12.4g %10.3g %12s  not in the baseline\n",
+                   metric.name.c_str(), "-", metric.value, metric.noise, "-");
+            ++missing;
+            continue;
+        }
+
+        const Metric& base = it->second;
+        metric.tolerance = base.tolerance;
+        if (!base.recorded) {
+            printf("%-26s %12s %12.4g %10.3g %12s  not recorded in the baseline\n",
+                   metric.name.c_str(), "-", metric.value, metric.noise, "-");
+            ++pending;
+            continue;
+        }
+        const double noise = std::sqrt(base.noise * base.noise + metric.noise * metric.noise);
+        const double limit = base.value * (1.0 + base.tolerance) + kNoiseFactor * noise;
+        const char* result = "ok";
+        if (metric.value > limit) {
+            result = "REGRESSION";
+            ++regressions;
+        }
+        else if (metric.value < base.value * (1.0 - base.tolerance) - kNoiseFactor * noise) {
+            result = "faster, consider updating the baseline";
+        }
+        printf("%-26s %12.4g %12.4g %10.3g %12.4g  %s\n",
+               metric.name.c_str(), base.value, metric.value, noise, limit, result);
+    }
+
+    for (const auto& entry : baseline) {
+        const bool measured = std::any_of(metrics.begin(), metrics.end(),
+                                          [&](const Metric& metric) { return metric.name == entry.first; });
+        if (measured)
+            continue;
+        if (!entry.second.recorded) {
+            printf("%-26s %12s %12s %10s %12s  not recorded, not measured by this build\n",
+                   entry.first.c_str(), "-", "-", "-", "-");
+            ++pending;
+            continue;
+        }
+        printf("%-26s %12.4g %12s %10s %12s  not measured by this build\n",
+               entry.first.c_str(), entry.second.value, "-", "-", "-");
+        ++missing;
+    }
+    return regressions;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    unsigned repeats = 11;
+    const char* baselinePath = nullptr;
+    const char* outputPath = nullptr;
+    bool update = false;
+    bool allowMissing = false;
+
+    const option longOptions[] = {
+        {"repeat", required_argument, nullptr, 'r'},
+        {"baseline", required_argument, nullptr, 'b'},
+        {"output", required_argument, nullptr, 'o'},
+        {"update", no_argument, nullptr, 'u'},
+        {"allow-missing", no_argument, nullptr, 'm'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    for (int c; (c = getopt_long(argc, argv, "r:b:o:umh", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'r':
+            repeats = (unsigned)atoi(optarg);
+            break;
+        case 'b':
+            baselinePath = optarg;
+            break;
+        case 'o':
+            outputPath = optarg;
+            break;
+        case 'u':
+            update = true;
+            break;
+        case 'm':
+            allowMissing = true;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc || repeats < 3 || (update && !baselinePath)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::map<std::string, Metric> baseline;
+    if (baselinePath && !readBaseline(baselinePath, baseline) && !update) {
+        fprintf(stderr, "perf: cannot read the baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    std::vector<Metric> metrics;
+    for (const RunMode& mode : kRunModes)
+        metrics.push_back(measureRun(mode, repeats));
+    metrics.push_back(measureMorph(repeats));
+    measureState(repeats, metrics);
+#if SIMPLEGAIN_PERF_UI
+    metrics.push_back(measureUiFrame(repeats));
+#endif
+
+    unsigned regressions = 0;
+    unsigned missing = 0;
+    unsigned pending = 0;
+    if (baselinePath && !update) {
+        regressions = compare(metrics, baseline, missing, pending);
+    }
+    else {
+        for (Metric& metric : metrics) {
+            const auto it = baseline.find(metric.name);
+            if (it != baseline.end())
+                metric.tolerance = it->second.tolerance;
+            printf("%-26s %12.4g %-9s noise %.3g\n",
+                   metric.name.c_str(), metric.value, metric.unit.c_str(), metric.noise);
+        }
+    }
+
+    if (update) {
+        // keep what this build cannot measure, such as the UI without ImGui
+        for (const auto& entry : baseline) {
+            if (std::none_of(metrics.begin(), metrics.end(),
+                             [&](const Metric& metric) { return metric.name == entry.first; }))
+                metrics.push_back(entry.second);
+        }
+        outputPath = baselinePath;
+    }
+    if (outputPath && !writeResults(outputPath, metrics)) {
+        fprintf(stderr, "perf: cannot write %s\n", outputPath);
+        return 2;
+    }
+
+    fflush(stdout);
+    if (regressions > 0)
+        fprintf(stderr, "perf: %u metric(s) regressed\n", regressions);
+    if (pending > 0)
+        fprintf(stderr, "perf: %u metric(s) not recorded in the baseline, not gated until a build "
+                "which measures them records the baseline again (make perf-baseline)\n", pending);
+    if (missing > 0 && !allowMissing)
+        fprintf(stderr, "perf: %u metric(s) missing on one side, record the baseline again "
+                "(make perf-baseline) or pass --allow-missing\n", missing);
+    return (regressions > 0 || (missing > 0 && !allowMissing)) ? 1 : 0;
+}
@@ -0,0 +1,350 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Makes and inspects the binary preset banks read by PluginSimpleGain.
+
+  simplegain-presets [options] bank.sgpresets
+
+  A bank is made from a text list, one preset per line: its category, a
+  tab, its name, a tab, then SYMBOL=VALUE pairs separated by spaces, where
+  a missing parameter takes its default value. Empty lines and lines which
+  start with '#' are skipped. A bank of generated presets can be made
+  instead, to try libraries of any size.
+
+  Without -c or -g, the bank is opened and described, and its lookups may
+  be timed. A search types its query one character at a time then erases
+  it, as in the preset browser of the UI, and times every keystroke. Set SIMPLEGAIN_PRESETS to the path of a bank to make it the
+  programs of the plugin.
+*/
+
+#include "PluginSimpleGain.hpp"
+#include "PresetBank.hpp"
+#include "PresetSearch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] bank.sgpresets\n"
+        "\n"
+        "  -c, --create LIST      write the bank from a text list of presets\n"
+        "  -g, --generate N       write a bank of N generated presets\n"
+        "  -f, --find NAME        show the preset of this name\n"
+        "  -C, --category NAME    list the presets of this category\n"
+        "  -s, --search QUERY     search names as the browser does, timing each keystroke\n"
+        "  -t, --time             time the lookups by name and by index\n"
+        "  -h, --help             show this help\n",
+        program);
+}
+
+// the program parameters, in order, are the columns of a bank
+static std::vector<uint32_t> getColumnParameters() {
+    std::vector<uint32_t> parameters;
+    for (uint32_t p = 0; p < PluginSimpleGain::paramCount; ++p) {
+        if (PluginSimpleGain::isProgramParameter(p))
+            parameters.push_back(p);
+    }
+    return parameters;
+}
+
+static PresetBankBuilder makeBuilder(const std::vector<uint32_t>& parameters) {
+    std::vector<std::string> symbols;
+    for (uint32_t p : parameters)
+        symbols.push_back(kParameterDescriptors[p].symbol);
+    return PresetBankBuilder(symbols);
+}
+
+static bool readList(const char* path, PresetBankBuilder& builder, const std::vector<uint32_t>& parameters) {
+    std::ifstream list(path);
+    if (!list) {
+        fprintf(stderr, "%s: cannot open file\n", path);
+        return false;
+    }
+
+    std::string line;
+    for (unsigned number = 1; std::getline(list, line); ++number) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        const size_t tab1 = line.find('\t');
+        if (tab1 == std::string::npos) {
+            fprintf(stderr, "%s:%u: expected category, tab, name, tab, values\n", path, number);
+            return false;
+        }
+        const size_t tab2 = std::min(line.find('\t', tab1 + 1), line.size());
+        const std::string category = line.substr(0, tab1);
+        const std::string name = line.substr(tab1 + 1, tab2 - tab1 - 1);
+
+        std::vector<float> values;
+        for (uint32_t p : parameters)
+            values.push_back(kParameterDescriptors[p].def);
+
+        std::istringstream assignments(line.substr(std::min(tab2 + 1, line.size())));
+        std::string assignment;
+        while (assignments >> assignment) {
+            const size_t equal = assignment.find('=');
+            const int index = (equal == std::string::npos) ? -1 :
+                kParameterSymbols.find(assignment.substr(0, equal).c_str());
+            uint32_t column = 0;
+            while (column < parameters.size() && (int)parameters[column] != index)
+                ++column;
+            if (column == parameters.size()) {
+                fprintf(stderr, "%s:%u: unknown parameter: %s\n", path, number, assignment.c_str());
+                return false;
+            }
+            values[column] = kParameterDescriptors[index].clamp(std::strtof(assignment.c_str() + equal + 1, nullptr));
+        }
+
+        if (!builder.add(name, category, values.data())) {
+            fprintf(stderr, "%s:%u: duplicate preset: %s\n", path, number, name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// presets spread over a few categories, with values over the whole ranges
+static void generate(PresetBankBuilder& builder, const std::vector<uint32_t>& parameters, uint32_t count) {
+    static const char* const categories[] = {
+        "Bass", "Drums", "Keys", "Mastering", "Mixing", "Pads", "Strings", "Vocals",
+    };
+    const uint32_t categoryCount = sizeof(categories) / sizeof(categories[0]);
+
+    uint32_t random = 1;
+    std::vector<float> values(parameters.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        for (size_t c = 0; c < parameters.size(); ++c) {
+            random = random * 1664525u + 1013904223u;
+            values[c] = kParameterDescriptors[parameters[c]].denormalize((float)(random >> 8) / 16777216.0f);
+        }
+        const char* const category = categories[i % categoryCount];
+        builder.add(std::string(category) + " " + std::to_string(i + 1), category, values.data());
+    }
+}
+
+static void printPreset(const PresetBank& bank, uint32_t index) {
+    printf("%6u  %-16s %-32s", index, bank.getPresetCategory(index), bank.getPresetName(index));
+    const float* const values = bank.getPresetValues(index);
+    for (uint32_t c = 0; c < bank.getColumnCount(); ++c)
+        printf(" %s=%g", bank.getColumnSymbol(c), values[c]);
+    printf("\n");
+}
+
+static void describe(const PresetBank& bank) {
+    printf("%u presets of %u parameters\n", bank.getPresetCount(), bank.getColumnCount());
+
+    // the categories, in the order of the category index
+    uint32_t rank = 0;
+    while (rank < bank.getPresetCount()) {
+        const char* const category = bank.getPresetCategory(bank.getSortedPreset(rank));
+        uint32_t first, end;
+        bank.findCategory(category, first, end);
+        printf("  %-24s %u\n", category, end - first);
+        rank = end;
+    }
+}
+
+static void timeLookups(const PresetBank& bank) {
+    typedef std::chrono::steady_clock Clock;
+    const uint32_t count = bank.getPresetCount();
+    if (count == 0)
+        return;
+
+    // the names are gathered first, in a scattered order
+    std::vector<const char*> names(count);
+    for (uint32_t i = 0; i < count; ++i)
+        names[i] = bank.getPresetName((uint32_t)(((uint64_t)i * 2654435761u) % count));
+
+    uint32_t found = 0;
+    const Clock::time_point start = Clock::now();
+    for (const char* name : names)
+        found += bank.findPreset(name) >= 0;
+    const double byName = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+    float sum = 0.0f;
+    const Clock::time_point start2 = Clock::now();
+    for (uint32_t i = 0; i < count; ++i)
+        sum += bank.getPresetValues((uint32_t)(((uint64_t)i * 2654435761u) % count))[0];
+    const double byIndex = std::chrono::duration<double, std::nano>(Clock::now() - start2).count() / count;
+
+    printf("lookup by name: %.1f ns, %u/%u found\n", byName, found, count);
+    printf("lookup by index: %.1f ns (checksum %g)\n", byIndex, sum);
+}
+
+static void searchAsTyped(const PresetBank& bank, const char* query) {
+    typedef std::chrono::steady_clock Clock;
+
+    PresetSearch search;
+    const Clock::time_point start = Clock::now();
+    search.build(bank);
+    const double buildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // every prefix as it is typed, then as it is erased
+    const std::string text(query);
+    std::vector<std::string> keystrokes;
+    for (size_t length = 1; length <= text.size(); ++length)
+        keystrokes.push_back(text.substr(0, length));
+    for (size_t length = text.size(); length-- > 0;)
+        keystrokes.push_back(text.substr(0, length));
+
+    double total = 0.0, worst = 0.0;
+    for (const std::string& keystroke : keystrokes) {
+        const Clock::time_point t0 = Clock::now();
+        search.search(keystroke.c_str());
+        const double time = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+        total += time;
+        worst = std::max(worst, time);
+    }
+
+    search.search(query);
+    printf("index of %u names built in %.3f ms\n", search.getPresetCount(), buildTime);
+    if (!keystrokes.empty())
+        printf("%zu keystrokes: %.1f us on average, %.1f us at worst\n", keystrokes.size(), total / keystrokes.size(), worst);
+    printf("%u presets match \"%s\"\n", search.getResultCount(), query);
+    for (uint32_t i = 0; i < search.getResultCount() && i < 10; ++i)
+        printPreset(bank, search.getResult(i));
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    const char* listPath = nullptr;
+    long generateCount = -1;
+    const char* findName = nullptr;
+    const char* categoryName = nullptr;
+    const char* searchQuery = nullptr;
+    bool timing = false;
+
+    static const struct option longOptions[] = {
+        {"create", required_argument, nullptr, 'c'},
+        {"generate", required_argument, nullptr, 'g'},
+        {"find", required_argument, nullptr, 'f'},
+        {"category", required_argument, nullptr, 'C'},
+        {"search", required_argument, nullptr, 's'},
+        {"time", no_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "c:g:f:C:s:th", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'c':
+            listPath = optarg;
+            break;
+        case 'g':
+            generateCount = std::atol(optarg);
+            break;
+        case 'f':
+            findName = optarg;
+            break;
+        case 'C':
+            categoryName = optarg;
+            break;
+        case 's':
+            searchQuery = optarg;
+            break;
+        case 't':
+            timing = true;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - optind != 1 || (listPath && generateCount >= 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* const bankPath = argv[optind];
+
+    if (listPath || generateCount >= 0) {
+        const std::vector<uint32_t> parameters = getColumnParameters();
+        PresetBankBuilder builder = makeBuilder(parameters);
+        if (listPath && !readList(listPath, builder, parameters))
+            return 1;
+        if (generateCount >= 0)
+            generate(builder, parameters, (uint32_t)generateCount);
+        if (!builder.write(bankPath)) {
+            fprintf(stderr, "%s: cannot write file\n", bankPath);
+            return 1;
+        }
+        printf("%s: %zu presets\n", bankPath, builder.getPresetCount());
+        return 0;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    PresetBank bank;
+    if (!bank.open(bankPath)) {
+        fprintf(stderr, "%s: %s\n", bankPath, bank.getError().c_str());
+        return 1;
+    }
+    const double openTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    if (findName) {
+        const int index = bank.findPreset(findName);
+        if (index < 0) {
+            fprintf(stderr, "%s: no preset named %s\n", bankPath, findName);
+            return 1;
+        }
+        printPreset(bank, (uint32_t)index);
+    }
+    else if (categoryName) {
+        uint32_t first, end;
+        bank.findCategory(categoryName, first, end);
+        for (uint32_t rank = first; rank < end; ++rank)
+            printPreset(bank, bank.getSortedPreset(rank));
+    }
+    else if (searchQuery) {
+        searchAsTyped(bank, searchQuery);
+    }
+    else {
+        describe(bank);
+        printf("opened in %.3f ms\n", openTime);
+    }
+
+    if (timing)
+        timeLookups(bank);
+
+    return 0;
+}
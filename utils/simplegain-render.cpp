@@ -0,0 +1,352 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Offline renderer: processes WAV files through PluginSimpleGain,
+  without a host.
+
+  simplegain-render [options] input.wav output.wav
+  simplegain-render [options] -o outdir input.wav|directory...
+
+  A single file is split into chunks rendered in parallel, with the output
+  identical to a sequential render. In batch mode, files are rendered
+  concurrently by a pool of workers, each with its own plugin instance,
+  which steal files from one another.
+*/
+
+#include "ChunkedRenderer.hpp"
+#include "OfflineRenderer.hpp"
+#include "WorkStealingPool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <getopt.h>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] input.wav output.wav\n"
+        "       %s [options] -o OUTDIR input.wav|directory...\n"
+        "\n"
+        "  -p, --param SYMBOL=VALUE   set a parameter (gain, saturation, limiter, ceiling)\n"
+        "  -a, --automation FILE      gain automation, lines of \"seconds dB\"\n"
+        "  -b, --block-size FRAMES    frames per run() call (default 8192)\n"
+        "  -c, --control-interval N   frames between automation updates (default 64)\n"
+        "  -o, --output-dir DIR       batch mode, write the outputs into DIR\n"
+        "  -j, --jobs N               number of workers (default: all cores)\n"
+        "  -h, --help                 show this help\n",
+        program, program);
+}
+
+// -----------------------------------------------------------------------
+// Batch mode
+
+struct BatchFile {
+    std::string input;
+    std::string output;
+    uint64_t size;
+};
+
+static bool endsWithWav(const char* name) {
+    const size_t length = strlen(name);
+    return length > 4 && strcasecmp(name + length - 4, ".wav") == 0;
+}
+
+static bool isSameFile(const char* a, const char* b) {
+    struct stat sa, sb;
+    return stat(a, &sa) == 0 && stat(b, &sb) == 0 &&
+        sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+/**
+  Render into a temporary file beside the output, which is renamed over
+  the output once complete; a failed render leaves the output as it was,
+  and a file which is mapped, as the inputs are, is never truncated.
+*/
+template <class Renderer>
+static bool renderReplacing(Renderer& renderer, const std::string& input, const std::string& output,
+                            RenderStats& stats, std::string& error) {
+    if (isSameFile(input.c_str(), output.c_str())) {
+        error = input + ": output would overwrite the input";
+        return false;
+    }
+
+    const std::string temporary = output + "." + std::to_string((long)getpid()) + ".tmp";
+    if (!renderer.render(input.c_str(), temporary.c_str(), stats)) {
+        error = renderer.getError();
+        unlink(temporary.c_str());
+        return false;
+    }
+    if (rename(temporary.c_str(), output.c_str()) != 0) {
+        error = output + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void addBatchFile(std::vector<BatchFile>& files, const std::string& path, const char* outputDir) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return;
+
+    const size_t slash = path.rfind('/');
+    const std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    files.push_back(BatchFile {path, std::string(outputDir) + "/" + name, (uint64_t)st.st_size});
+}
+
+/**
+  Collect the inputs, directories contribute their WAV files.
+*/
+static std::vector<BatchFile> collectBatchFiles(char* const* paths, int count, const char* outputDir) {
+    std::vector<BatchFile> files;
+
+    for (int i = 0; i < count; ++i) {
+        struct stat st;
+        if (stat(paths[i], &st) != 0) {
+            fprintf(stderr, "%s: cannot access\n", paths[i]);
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            addBatchFile(files, paths[i], outputDir);
+            continue;
+        }
+        if (DIR* dir = opendir(paths[i])) {
+            while (const dirent* entry = readdir(dir)) {
+                if (endsWithWav(entry->d_name))
+                    addBatchFile(files, std::string(paths[i]) + "/" + entry->d_name, outputDir);
+            }
+            closedir(dir);
+        }
+    }
+
+    return files;
+}
+
+static int runBatch(RenderOptions options, char* const* paths, int count,
+                    const char* outputDir, unsigned jobs) {
+    std::vector<BatchFile> files = collectBatchFiles(paths, count, outputDir);
+    if (files.empty()) {
+        fprintf(stderr, "No input files\n");
+        return 1;
+    }
+
+    // the outputs are named after the inputs alone, so inputs of the same
+    // name from different directories would write the same file at once
+    std::vector<const BatchFile*> byOutput;
+    for (const BatchFile& file : files)
+        byOutput.push_back(&file);
+    std::sort(byOutput.begin(), byOutput.end(),
+              [](const BatchFile* a, const BatchFile* b) { return a->output < b->output; });
+    bool duplicates = false;
+    for (size_t i = 1; i < byOutput.size(); ++i) {
+        if (byOutput[i]->output == byOutput[i - 1]->output) {
+            fprintf(stderr, "%s and %s: both would be written to %s\n", byOutput[i - 1]->input.c_str(),
+                    byOutput[i]->input.c_str(), byOutput[i]->output.c_str());
+            duplicates = true;
+        }
+    }
+    if (duplicates)
+        return 1;
+
+    // smallest first: each worker starts with the largest of its share,
+    // and thieves take the small ones which remain at the end
+    std::sort(files.begin(), files.end(),
+              [](const BatchFile& a, const BatchFile& b) { return a.size < b.size; });
+
+    uint64_t totalBytes = 0;
+    for (const BatchFile& file : files)
+        totalBytes += file.size;
+
+    RenderProgress progress;
+    options.progress = &progress;
+
+    if (jobs > files.size())
+        jobs = (unsigned)files.size();
+
+    std::vector<std::unique_ptr<OfflineRenderer>> renderers;
+    for (unsigned i = 0; i < jobs; ++i)
+        renderers.emplace_back(new OfflineRenderer(options));
+
+    std::atomic<uint32_t> done {0};
+    std::mutex errorMutex;
+    std::vector<std::string> errors;
+
+    auto renderTask = [&](uint32_t task, unsigned worker) {
+        const BatchFile& file = files[task];
+        RenderStats stats;
+        std::string error;
+        if (!renderReplacing(*renderers[worker], file.input, file.output, stats, error)) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            errors.push_back(error);
+        }
+        done.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    std::vector<uint32_t> tasks(files.size());
+    for (uint32_t i = 0; i < tasks.size(); ++i)
+        tasks[i] = i;
+
+    WorkStealingPool pool(jobs, (uint32_t)tasks.size());
+    const auto startTime = std::chrono::steady_clock::now();
+
+    pool.start(tasks.data(), (uint32_t)tasks.size(), (uint32_t)tasks.size(),
+               [](void* context, uint32_t task, unsigned worker) {
+                   (*(decltype(renderTask)*)context)(task, worker);
+               }, &renderTask);
+
+    bool finished;
+    do {
+        finished = pool.waitFor(std::chrono::milliseconds(500));
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        const double audio = progress.audioMicroseconds.load(std::memory_order_relaxed) * 1e-6;
+        const double megabytes = progress.bytes.load(std::memory_order_relaxed) / 1e6;
+        fprintf(stderr, "\r[%u/%zu files] %.1f%%, %.0f s of audio, %.1fx realtime, %.1f MB/s   ",
+                done.load(std::memory_order_relaxed), files.size(),
+                100.0 * megabytes * 1e6 / (double)totalBytes,
+                audio, audio / elapsed, megabytes / elapsed);
+    } while (!finished);
+
+    fprintf(stderr, "\n%u workers\n", jobs);
+    for (const std::string& error : errors)
+        fprintf(stderr, "%s\n", error.c_str());
+    return errors.empty() ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    RenderOptions options;
+    AutomationCurve automation;
+    const char* outputDir = nullptr;
+    unsigned jobs = std::thread::hardware_concurrency();
+
+    // a throwaway instance to look up parameters by symbol
+    HeadlessPlugin* lookup = HeadlessPlugin::create(48000.0, options.blockSize);
+
+    static const struct option longOptions[] = {
+        {"param", required_argument, nullptr, 'p'},
+        {"automation", required_argument, nullptr, 'a'},
+        {"block-size", required_argument, nullptr, 'b'},
+        {"control-interval", required_argument, nullptr, 'c'},
+        {"output-dir", required_argument, nullptr, 'o'},
+        {"jobs", required_argument, nullptr, 'j'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "p:a:b:c:o:j:h", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'p': {
+            char* equal = strchr(optarg, '=');
+            if (!equal) {
+                fprintf(stderr, "Invalid parameter setting: %s\n", optarg);
+                return 1;
+            }
+            *equal = '\0';
+            const int index = lookup->findParameter(optarg);
+            if (index < 0 || PluginSimpleGain::isOutputParameter(index)) {
+                fprintf(stderr, "Unknown parameter: %s\n", optarg);
+                return 1;
+            }
+            options.parameters.emplace_back((uint32_t)index, (float)atof(equal + 1));
+            break;
+        }
+        case 'a':
+            if (!automation.load(optarg)) {
+                fprintf(stderr, "%s: %s\n", optarg, automation.getError().c_str());
+                return 1;
+            }
+            options.gainAutomation = &automation;
+            break;
+        case 'b':
+            options.blockSize = (uint32_t)atoi(optarg);
+            break;
+        case 'c':
+            options.controlInterval = (uint32_t)atoi(optarg);
+            break;
+        case 'o':
+            outputDir = optarg;
+            break;
+        case 'j':
+            jobs = (unsigned)atoi(optarg);
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    delete lookup;
+
+    if (options.blockSize == 0 || options.controlInterval == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (outputDir) {
+        if (optind == argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        return runBatch(options, argv + optind, argc - optind, outputDir, jobs ? jobs : 1);
+    }
+
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ChunkedRenderer renderer(options, jobs ? jobs : 1);
+    RenderStats stats;
+    std::string error;
+    if (!renderReplacing(renderer, argv[optind], argv[optind + 1], stats, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    const double duration = stats.frames / stats.sampleRate;
+    fprintf(stderr, "%llu frames (%.1f s) in %.3f s, %.1fx realtime, true peak %.1f dBTP, %u chunk(s)\n",
+            (unsigned long long)stats.frames, duration, stats.seconds,
+            duration / stats.seconds, stats.truePeakDb, renderer.getChunkCount());
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Checks that the chunked render of one file is bit-identical to its
+  sequential render: renders a noise file with a gain automation both
+  ways, over block sizes down to one frame, control intervals, worker
+  counts, stages and sample formats, and compares the output bytes.
+
+  Built and run by `make check`.
+*/
+
+#include "ChunkedRenderer.hpp"
+#include "OfflineRenderer.hpp"
+#include "WavFile.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+struct RenderCase {
+    uint32_t blockSize;
+    uint32_t controlInterval;
+    unsigned jobs;
+    bool saturation;
+};
+
+// blocks shorter than the preroll of a chunk too
+static const RenderCase kCases[] = {
+    {8192, 64, 4, false},
+    {8192, 64, 4, true},
+    {1000, 7, 3, true},
+    {17, 5, 3, false},
+    {8, 64, 6, true},
+    {2, 64, 6, false},
+    {1, 64, 2, true},
+    {1, 1, 6, false},
+};
+
+static const uint32_t kSampleRate = 48000;
+static const uint32_t kFrames = 2 * kSampleRate + 123;
+
+/**
+  Noise at -6 dBFS, hot enough for the clipper to act.
+*/
+static bool writeInput(const char* path, uint16_t channels, uint16_t bitsPerSample, bool isFloat) {
+    WavFormat format;
+    format.channels = channels;
+    format.sampleRate = kSampleRate;
+    format.bitsPerSample = bitsPerSample;
+    format.isFloat = isFloat;
+
+    WavWriter writer;
+    if (!writer.open(path, format))
+        return false;
+
+    std::vector<uint8_t> frame(format.bytesPerFrame());
+    uint32_t random = 1;
+    for (uint32_t i = 0; i < kFrames; ++i) {
+        for (uint16_t c = 0; c < channels; ++c) {
+            random = random * 1664525u + 1013904223u;
+            const float sample = 0.5f * ((float)(random >> 8) * (2.0f / 16777216.0f) - 1.0f);
+            uint8_t* const out = frame.data() + c * (bitsPerSample / 8);
+            if (isFloat) {
+                memcpy(out, &sample, sizeof(sample));
+            } else {
+                const int16_t value = (int16_t)(sample * 32767.0f);
+                out[0] = (uint8_t)value;
+                out[1] = (uint8_t)(value >> 8);
+            }
+        }
+        if (!writer.write(frame.data(), 1))
+            return false;
+    }
+    return writer.close();
+}
+
+static bool writeAutomation(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+    fputs("0 -12\n0.3 6\n0.31 -30\n1.2 0\n1.7 -6\n", file);
+    return fclose(file) == 0;
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    data.clear();
+    uint8_t buffer[65536];
+    for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+        data.insert(data.end(), buffer, buffer + count);
+    fclose(file);
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+int main() {
+    char directory[] = "/tmp/simplegain-rendercheck-XXXXXX";
+    if (!mkdtemp(directory)) {
+        fprintf(stderr, "rendercheck: cannot make a temporary directory\n");
+        return 1;
+    }
+    const std::string base = directory;
+    const std::string inputs[] = {base + "/stereo-float.wav", base + "/mono-16.wav"};
+    const std::string curvePath = base + "/gain.txt";
+    const std::string sequentialPath = base + "/sequential.wav";
+    const std::string chunkedPath = base + "/chunked.wav";
+
+    AutomationCurve curve;
+    if (!writeInput(inputs[0].c_str(), 2, 32, true) || !writeInput(inputs[1].c_str(), 1, 16, false) ||
+        !writeAutomation(curvePath.c_str()) || !curve.load(curvePath.c_str())) {
+        fprintf(stderr, "rendercheck: cannot write the inputs in %s\n", directory);
+        return 1;
+    }
+
+    HeadlessPlugin* probe = HeadlessPlugin::create(kSampleRate, 64);
+    const int saturation = probe->findParameter("saturation");
+    delete probe;
+
+    unsigned failures = 0, renders = 0;
+    for (const RenderCase& test : kCases) {
+        RenderOptions options;
+        options.blockSize = test.blockSize;
+        options.controlInterval = test.controlInterval;
+        options.parameters.emplace_back((uint32_t)saturation, test.saturation ? 1.0f : 0.0f);
+        options.gainAutomation = &curve;
+
+        for (const std::string& input : inputs) {
+            OfflineRenderer sequential(options);
+            ChunkedRenderer chunked(options, test.jobs);
+            RenderStats stats;
+            std::vector<uint8_t> expected, actual;
+
+            const bool rendered =
+                sequential.render(input.c_str(), sequentialPath.c_str(), stats) &&
+                chunked.render(input.c_str(), chunkedPath.c_str(), stats) &&
+                readFile(sequentialPath.c_str(), expected) &&
+                readFile(chunkedPath.c_str(), actual);
+            const bool split = chunked.getChunkCount() > 1;
+            const bool ok = rendered && split && expected == actual;
+            ++renders;
+
+            if (!ok) {
+                ++failures;
+                fprintf(stderr, "rendercheck: -b %u -c %u -j %u%s, %s: %s\n",
+                        test.blockSize, test.controlInterval, test.jobs,
+                        test.saturation ? " -p saturation=1" : "", input.c_str() + base.size() + 1,
+                        !rendered ? "render failed" : !split ? "not split into chunks" : "output differs");
+            }
+        }
+    }
+
+    for (const std::string& path : {inputs[0], inputs[1], curvePath, sequentialPath, chunkedPath})
+        unlink(path.c_str());
+    rmdir(directory);
+
+    printf("rendercheck: %u chunked render(s) against sequential ones, %u difference(s)\n", renders, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Replays a host call trace recorded with SIMPLEGAIN_TRACE against a fresh
+  PluginSimpleGain, and times every call.
+
+  simplegain-replay [options] trace.sgtrace
+
+  The calls are made in the recorded order, from a single thread, as fast
+  as possible. run() processes a deterministic noise signal.
+*/
+
+#include "HeadlessPlugin.hpp"
+#include "HostTrace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] trace.sgtrace\n"
+        "\n"
+        "  -n, --repeat N       replay the trace N times (default 1)\n"
+        "  -s, --slowest N      list the N slowest calls (default 10)\n"
+        "  -o, --output FILE    write the time of every call as CSV\n"
+        "  -l, --load FILE      write the DSP load histogram of the last replay as JSON\n"
+        "  -h, --help           show this help\n",
+        program);
+}
+
+static const char* eventName(uint8_t type) {
+    switch (type) {
+    case kTraceSetParameter: return "setParameterValue";
+    case kTraceLoadProgram: return "loadProgram";
+    case kTraceSampleRate: return "sampleRateChanged";
+    case kTraceActivate: return "activate";
+    case kTraceRun: return "run";
+    case kTraceDropped: return "dropped";
+    }
+    return "unknown";
+}
+
+static void describeEvent(const HostTraceEvent& event, char* text, size_t size) {
+    switch (event.type) {
+    case kTraceSetParameter:
+        snprintf(text, size, "%u, %g", event.param.index, event.param.value);
+        break;
+    case kTraceLoadProgram:
+        snprintf(text, size, "%u", event.param.index);
+        break;
+    case kTraceSampleRate:
+        snprintf(text, size, "%g", event.sampleRate);
+        break;
+    case kTraceRun:
+        snprintf(text, size, "%u", event.frames);
+        break;
+    default:
+        text[0] = '\0';
+        break;
+    }
+}
+
+static bool loadTrace(const char* path, HostTraceHeader& header, std::vector<HostTraceEvent>& events) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return false;
+    }
+
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, "SGTRACE", 8) == 0 &&
+        header.version == kHostTraceVersion &&
+        header.eventSize == sizeof(HostTraceEvent);
+
+    HostTraceEvent event;
+    while (ok && fread(&event, sizeof(event), 1, file) == 1)
+        events.push_back(event);
+    fclose(file);
+
+    if (!ok) {
+        fprintf(stderr, "%s: not a trace of this version\n", path);
+        return false;
+    }
+
+    // the buffers of different threads are written one after the other
+    std::stable_sort(events.begin(), events.end(),
+                     [](const HostTraceEvent& a, const HostTraceEvent& b) { return a.sequence < b.sequence; });
+    return true;
+}
+
+// -----------------------------------------------------------------------
+
+struct Timing {
+    uint32_t event;
+    double nanoseconds;
+};
+
+int main(int argc, char* argv[]) {
+    unsigned repeat = 1;
+    unsigned slowest = 10;
+    const char* csvPath = nullptr;
+    const char* loadPath = nullptr;
+
+    static const struct option longOptions[] = {
+        {"repeat", required_argument, nullptr, 'n'},
+        {"slowest", required_argument, nullptr, 's'},
+        {"output", required_argument, nullptr, 'o'},
+        {"load", required_argument, nullptr, 'l'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    for (int c; (c = getopt_long(argc, argv, "n:s:o:l:h", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'n':
+            repeat = (unsigned)atoi(optarg);
+            break;
+        case 's':
+            slowest = (unsigned)atoi(optarg);
+            break;
+        case 'o':
+            csvPath = optarg;
+            break;
+        case 'l':
+            loadPath = optarg;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - optind != 1 || repeat == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // do not record the replay itself
+    unsetenv("SIMPLEGAIN_TRACE");
+
+    HostTraceHeader header;
+    std::vector<HostTraceEvent> events;
+    if (!loadTrace(argv[optind], header, events))
+        return 1;
+
+    uint32_t maxFrames = header.bufferSize;
+    uint64_t dropped = 0;
+    uint32_t invalid = 0;
+    for (const HostTraceEvent& event : events) {
+        if (event.type == kTraceRun)
+            maxFrames = std::max(maxFrames, event.frames);
+        else if (event.type == kTraceDropped)
+            dropped += event.param.index;
+        else if (event.type == kTraceSetParameter && event.param.index >= PluginSimpleGain::paramCount)
+            ++invalid;
+    }
+    if (dropped > 0)
+        fprintf(stderr, "warning: %llu calls were not recorded, the buffers were full\n",
+                (unsigned long long)dropped);
+    if (invalid > 0)
+        fprintf(stderr, "warning: %u parameter changes of unknown parameters are skipped\n", invalid);
+
+    // white noise at -20 dBFS, the same for every replay
+    std::vector<float> buffers[4];
+    uint32_t random = 1;
+    for (std::vector<float>& buffer : buffers) {
+        buffer.resize(maxFrames);
+        for (float& sample : buffer) {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            sample = 0.1f * ((float)(random >> 8) * (2.0f / 16777216.0f) - 1.0f);
+        }
+    }
+    const float* inputs[2] = {buffers[0].data(), buffers[1].data()};
+    float* outputs[2] = {buffers[2].data(), buffers[3].data()};
+
+    std::vector<Timing> timings;
+    timings.reserve(events.size() * repeat);
+
+    for (unsigned r = 0; r < repeat; ++r) {
+        HeadlessPlugin* plugin = HeadlessPlugin::create(header.sampleRate, header.bufferSize);
+
+        for (uint32_t i = 0; i < events.size(); ++i) {
+            const HostTraceEvent& event = events[i];
+            const auto start = std::chrono::steady_clock::now();
+
+            switch (event.type) {
+            case kTraceSetParameter:
+                // a trace of another version, or damaged
+                if (event.param.index >= PluginSimpleGain::paramCount)
+                    continue;
+                plugin->setParameterValue(event.param.index, event.param.value);
+                break;
+            case kTraceLoadProgram:
+                plugin->loadProgram(event.param.index);
+                break;
+            case kTraceSampleRate:
+                plugin->sampleRateChanged(event.sampleRate);
+                break;
+            case kTraceActivate:
+                plugin->activate();
+                break;
+            case kTraceRun:
+                plugin->run(inputs, outputs, event.frames);
+                break;
+            default:
+                continue;
+            }
+
+            const auto end = std::chrono::steady_clock::now();
+            timings.push_back(Timing {i, std::chrono::duration<double, std::nano>(end - start).count()});
+        }
+
+        if (r + 1 == repeat && loadPath) {
+            // measured by the plugin itself, since its last activation
+            FILE* json = fopen(loadPath, "w");
+            if (!json) {
+                fprintf(stderr, "%s: cannot create\n", loadPath);
+                return 1;
+            }
+            plugin->getLoadMeter().writeJson(json);
+            fclose(json);
+        }
+
+        delete plugin;
+    }
+
+    // statistics by kind of call
+    printf("%-18s %10s %10s %10s %10s %10s %12s\n",
+           "call", "count", "mean ns", "p50 ns", "p99 ns", "max ns", "ns/frame");
+    for (uint8_t type = kTraceSetParameter; type <= kTraceRun; ++type) {
+        std::vector<double> times;
+        double total = 0.0;
+        uint64_t frames = 0;
+        for (const Timing& timing : timings) {
+            if (events[timing.event].type != type)
+                continue;
+            times.push_back(timing.nanoseconds);
+            total += timing.nanoseconds;
+            if (type == kTraceRun)
+                frames += events[timing.event].frames;
+        }
+        if (times.empty())
+            continue;
+
+        std::sort(times.begin(), times.end());
+        const size_t count = times.size();
+        printf("%-18s %10zu %10.0f %10.0f %10.0f %10.0f",
+               eventName(type), count, total / count,
+               times[count / 2], times[std::min(count - 1, count * 99 / 100)], times.back());
+        if (type == kTraceRun)
+            printf(" %12.2f", total / (double)frames);
+        printf("\n");
+    }
+
+    // the calls to look at first
+    std::vector<Timing> sorted(timings);
+    const size_t listed = std::min<size_t>(slowest, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + listed, sorted.end(),
+                      [](const Timing& a, const Timing& b) { return a.nanoseconds > b.nanoseconds; });
+    if (listed > 0)
+        printf("\nslowest calls:\n");
+    for (size_t i = 0; i < listed; ++i) {
+        const HostTraceEvent& event = events[sorted[i].event];
+        char args[64];
+        describeEvent(event, args, sizeof(args));
+        printf("  #%-10u %s(%s) %.0f ns\n", event.sequence, eventName(event.type), args, sorted[i].nanoseconds);
+    }
+
+    if (csvPath) {
+        FILE* csv = fopen(csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "%s: cannot create\n", csvPath);
+            return 1;
+        }
+        fprintf(csv, "sequence,thread,call,arguments,ns\n");
+        for (const Timing& timing : timings) {
+            const HostTraceEvent& event = events[timing.event];
+            char args[64];
+            describeEvent(event, args, sizeof(args));
+            fprintf(csv, "%u,%u,%s,\"%s\",%.0f\n", event.sequence, event.thread,
+                    eventName(event.type), args, timing.nanoseconds);
+        }
+        fclose(csv);
+    }
+
+    return 0;
+}
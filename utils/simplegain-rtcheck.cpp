@@ -0,0 +1,342 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Checks that PluginSimpleGain keeps its realtime-safety claim
+  (DISTRHO_PLUGIN_IS_RT_SAFE): runs it through all its processing modes,
+  sample rates and block sizes, and fails if run(), loadProgram(), a move
+  of the morph, an A/B slot change or a state from the editor ever
+  allocates, locks or makes a blocking system call.
+
+  Then it races thousands of replacements of the preset bank, made on
+  another thread, against loadProgram() and run(), and checks that the
+  readers of an EpochReclaimer never see an object which was destroyed.
+
+  Built and run by `make check`; see RealtimeGuard.hpp.
+*/
+
+#include "HeadlessPlugin.hpp"
+#include "RealtimeGuard.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static const double kSampleRates[] = {44100.0, 48000.0, 96000.0};
+static const uint32_t kBlockSizes[] = {1, 17, 64, 256, 1000, 4096};
+static const uint32_t kMaxBlockSize = 4096;
+static const uint32_t kSwaps = 5000;
+
+/**
+  Make sure the interception is in place: a check which never fires
+  would pass for the wrong reason.
+*/
+static bool selfTest() {
+    // volatile, or the compiler may elide the allocations
+    void* volatile block;
+    int* volatile object;
+
+    RealtimeGuard::setReporting(false);
+    {
+        RealtimeScope scope("self-test");
+        block = malloc(16);
+        free(block);
+        object = new int(1);
+        delete object;
+    }
+    const bool ok = RealtimeGuard::getViolationCount() == 4;
+    RealtimeGuard::resetViolationCount();
+    RealtimeGuard::setReporting(true);
+    return ok;
+}
+
+// -----------------------------------------------------------------------
+// Races of the reclamation
+
+/**
+  Objects are marked dead instead of freed, and kept until the end, so
+  that a reader which still sees one is caught rather than undefined.
+*/
+struct RaceObject {
+    enum { kAlive = 0x11fe, kDead = 0xdead };
+    std::atomic<uint32_t> state {kAlive};
+};
+
+static std::mutex gGraveyardMutex;
+static std::vector<RaceObject*> gGraveyard;
+
+static void buryRaceObject(void* object) {
+    RaceObject* const race = (RaceObject*)object;
+    race->state.store(RaceObject::kDead, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(gGraveyardMutex);
+    gGraveyard.push_back(race);
+}
+
+/**
+  Readers on several threads against a writer replacing the object; count
+  the reads of a dead object.
+*/
+static uint64_t raceReclaimer(uint64_t& reads) {
+    EpochReclaimer reclaimer;
+    std::atomic<RaceObject*> current {new RaceObject};
+    std::atomic<bool> done {false};
+    std::atomic<uint64_t> readCount {0}, deadCount {0};
+
+    const auto reader = [&]() {
+        uint64_t count = 0, dead = 0;
+        RealtimeScope scope("EpochReclaimer::ReadGuard");
+        while (!done.load(std::memory_order_relaxed)) {
+            EpochReclaimer::ReadGuard guard(reclaimer);
+            RaceObject* const object = current.load(std::memory_order_seq_cst);
+            for (unsigned i = 0; i < 16; ++i)
+                dead += object->state.load(std::memory_order_relaxed) != RaceObject::kAlive;
+            ++count;
+        }
+        readCount += count;
+        deadCount += dead;
+    };
+
+    std::vector<std::thread> readers;
+    for (unsigned i = 0; i < 3; ++i)
+        readers.emplace_back(reader);
+
+    for (uint32_t swap = 0; swap < kSwaps; ++swap) {
+        RaceObject* const old = current.exchange(new RaceObject, std::memory_order_seq_cst);
+        reclaimer.retire(old, buryRaceObject);
+        if (swap % 64 == 0)
+            std::this_thread::yield();
+    }
+
+    done = true;
+    for (std::thread& thread : readers)
+        thread.join();
+    while (reclaimer.collect() != 0)
+        std::this_thread::yield();
+
+    if (reclaimer.getDestroyedCount() != kSwaps) {
+        fprintf(stderr, "rtcheck: %llu of %u retired objects destroyed\n",
+                (unsigned long long)reclaimer.getDestroyedCount(), kSwaps);
+        ++deadCount;
+    }
+
+    delete current.load();
+    for (RaceObject* object : gGraveyard)
+        delete object;
+    gGraveyard.clear();
+
+    reads = readCount;
+    return deadCount;
+}
+
+/**
+  Replace the preset bank of the process on another thread, while the
+  plugin loads programs and runs; the programs of each bank hold its own
+  gain, which the plugin must read whole.
+*/
+static uint64_t racePresetBanks(HeadlessPlugin* plugin, const float** inputs, float** outputs,
+                                int gain, uint64_t& programs) {
+    std::vector<std::string> columns;
+    for (uint32_t p = 0; p < PluginSimpleGain::paramCount; ++p) {
+        if (PluginSimpleGain::isProgramParameter(p))
+            columns.push_back(kParameterDescriptors[p].symbol);
+    }
+
+    std::atomic<bool> done {false};
+    std::thread writer([&]() {
+        for (uint32_t swap = 0; swap < kSwaps; ++swap) {
+            PresetBankBuilder builder(columns);
+            std::vector<float> values(columns.size(), 0.0f);
+            values[gain] = -(float)(swap % 80);
+            builder.add("Race A", "Race", values.data());
+            builder.add("Race B", "Race", values.data());
+            PresetBank* bank = new PresetBank;
+            bank->open(builder.build());
+            PluginSimpleGain::setPresetBank(bank);
+        }
+        done = true;
+    });
+
+    uint64_t torn = 0;
+    while (!done.load(std::memory_order_relaxed)) {
+        {
+            RealtimeScope scope("loadProgram()");
+            plugin->loadProgram((uint32_t)(programs++ & 1));
+        }
+        const float value = plugin->getParameterValue((uint32_t)gain);
+        torn += value != (float)(int)value || value > 0.0f || value < -79.0f;
+        RealtimeScope scope("run()");
+        plugin->run(inputs, outputs, 64);
+    }
+    writer.join();
+    return torn;
+}
+
+// -----------------------------------------------------------------------
+
+int main() {
+    if (!selfTest()) {
+        fprintf(stderr, "rtcheck: allocations are not intercepted, the check is not valid\n");
+        return 1;
+    }
+
+    // noise at -6 dBFS, hot enough for the clipper and the limiter to act
+    std::vector<float> buffers[4];
+    uint32_t random = 1;
+    for (std::vector<float>& buffer : buffers) {
+        buffer.resize(kMaxBlockSize);
+        for (float& sample : buffer) {
+            random = random * 1664525u + 1013904223u;
+            sample = 0.5f * ((float)(random >> 8) * (2.0f / 16777216.0f) - 1.0f);
+        }
+    }
+    const float* inputs[2] = {buffers[0].data(), buffers[1].data()};
+    float* outputs[2] = {buffers[2].data(), buffers[3].data()};
+
+    HeadlessPlugin* plugin = HeadlessPlugin::create(kSampleRates[0], kMaxBlockSize);
+    const int saturation = plugin->findParameter("saturation");
+    const int limiter = plugin->findParameter("limiter");
+    const int gain = plugin->findParameter("gain");
+    const int morph = plugin->findParameter("morph");
+    const int abSlot = plugin->findParameter("ab_slot");
+    uint64_t runs = 0, programs = 0, morphs = 0, slots = 0, states = 0;
+
+    for (double sampleRate : kSampleRates) {
+        plugin->sampleRateChanged(sampleRate);
+
+        for (unsigned mode = 0; mode < 4; ++mode) {
+            plugin->setParameterValue(saturation, (mode & 1) ? 1.0f : 0.0f);
+            plugin->setParameterValue(limiter, (mode & 2) ? 1.0f : 0.0f);
+            plugin->activate();
+
+            for (uint32_t blockSize : kBlockSizes) {
+                // a quarter of a second, with the gain moving every block
+                const uint32_t blocks = (uint32_t)(sampleRate / 4) / blockSize + 1;
+                for (uint32_t b = 0; b < blocks; ++b) {
+                    plugin->setParameterValue(gain, (float)(b % 24) - 12.0f);
+                    RealtimeScope scope("run()");
+                    plugin->run(inputs, outputs, blockSize);
+                    ++runs;
+                }
+            }
+
+            for (uint32_t index = 0; index < PluginSimpleGain::getPresetBank()->getPresetCount(); ++index) {
+                {
+                    RealtimeScope scope("loadProgram()");
+                    plugin->loadProgram(index);
+                    ++programs;
+                }
+                RealtimeScope scope("run()");
+                plugin->run(inputs, outputs, 64);
+                ++runs;
+            }
+
+            // the morph moving every block, to snapshots in the other modes
+            const float from[] = {-12.0f, (mode & 1) ? 1.0f : 0.0f, (mode & 2) ? 1.0f : 0.0f, -1.0f};
+            const float to[] = {6.0f, (mode & 1) ? 0.0f : 1.0f, (mode & 2) ? 0.0f : 1.0f, -6.0f};
+            plugin->setMorphSnapshot(0, from);
+            plugin->setMorphSnapshot(1, to);
+            for (uint32_t b = 0; b < 256; ++b) {
+                {
+                    RealtimeScope scope("setParameterValue(morph)");
+                    plugin->setParameterValue(morph, (float)(b % 16) / 15.0f);
+                    ++morphs;
+                }
+                RealtimeScope scope("run()");
+                plugin->run(inputs, outputs, 64);
+                ++runs;
+            }
+            plugin->clearMorphSnapshots();
+
+            // the morph snapshots as the editor stores them, which an LV2
+            // host delivers on the realtime thread
+            StateWriter writer;
+            writer.beginField(PluginSimpleGain::kStateMorphSnapshots);
+            writer.writeVarint(2);
+            for (const float* snapshot : {from, to}) {
+                for (uint32_t index = 0; index < PluginSimpleGain::paramMorph; ++index)
+                    writer.writeFloat(snapshot[index]);
+            }
+            writer.endField();
+            const std::vector<uint8_t>& snapshots = writer.finish();
+            const std::string state = encodeBase64(snapshots.data(), snapshots.size());
+            for (uint32_t b = 0; b < 16; ++b) {
+                {
+                    RealtimeScope scope("setState()");
+                    plugin->setState("session", state.c_str());
+                    ++states;
+                }
+                RealtimeScope scope("run()");
+                plugin->run(inputs, outputs, 64);
+                ++runs;
+            }
+            plugin->clearMorphSnapshots();
+
+            // the A/B slot changing every block, the other slot in the other modes
+            for (uint32_t b = 0; b < 64; ++b) {
+                {
+                    RealtimeScope scope("setParameterValue(ab_slot)");
+                    plugin->setParameterValue(abSlot, (float)(b & 1));
+                    ++slots;
+                }
+                if (b == 1) {
+                    plugin->setParameterValue(saturation, (mode & 1) ? 0.0f : 1.0f);
+                    plugin->setParameterValue(limiter, (mode & 2) ? 0.0f : 1.0f);
+                }
+                RealtimeScope scope("run()");
+                plugin->run(inputs, outputs, 64);
+                ++runs;
+            }
+            plugin->setParameterValue(abSlot, 0.0f);
+        }
+    }
+
+    // the race replaces the bank, which the next checks may not expect
+    uint64_t racePrograms = 0;
+    const uint64_t torn = racePresetBanks(plugin, inputs, outputs, gain, racePrograms);
+    programs += racePrograms;
+
+    delete plugin;
+
+    uint64_t reads = 0;
+    const uint64_t dead = raceReclaimer(reads);
+    fprintf(stderr, "rtcheck: %u bank swaps against %llu loadProgram() calls, %llu torn program(s)\n",
+            kSwaps, (unsigned long long)racePrograms, (unsigned long long)torn);
+    fprintf(stderr, "rtcheck: %u swaps against %llu guarded reads, %llu read(s) of a destroyed object\n",
+            kSwaps, (unsigned long long)reads, (unsigned long long)dead);
+
+    const uint64_t violations = RealtimeGuard::getViolationCount();
+    fprintf(stderr, "rtcheck: %llu run(), %llu loadProgram(), %llu morph, %llu A/B slot and %llu state calls, %llu violation(s)\n",
+            (unsigned long long)runs, (unsigned long long)programs, (unsigned long long)morphs,
+            (unsigned long long)slots, (unsigned long long)states, (unsigned long long)violations);
+    return (violations == 0 && torn == 0 && dead == 0) ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+/*
+ * Simple Gain audio effect based on DISTRHO Plugin Framework (DPF)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2021 Jean Pierre Cimalando <jp-dev@inbox.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+  Stress host: runs many PluginSimpleGain instances wired as a mixer graph
+  on several cores, against the deadline of an audio callback.
+
+  simplegain-stress [options]
+
+  For each instance count and thread count, the graph is processed block
+  by block, paced by a simulated audio clock. A block misses its deadline
+  when it completes later than one period after it was due. The scaling
+  efficiency compares the processing time of a block with that on one
+  thread, and the footprint of an instance tells how many of them fit in
+  the caches.
+*/
+
+#include "MixerGraph.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+struct Options {
+    std::vector<uint32_t> instances {100, 500, 1000};
+    std::vector<unsigned> threads;
+    MixerGraph::Layout layout;
+    double sampleRate = 48000.0;
+    uint32_t blockSize = 128;
+    double duration = 2.0;
+    bool paced = true;
+    bool memoryReport = false;
+};
+
+struct Result {
+    double mean;  // processing time of a block, in seconds
+    double p99;
+    double max;
+    uint32_t misses;
+    uint32_t blocks;
+};
+
+void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "  -n, --instances LIST  instance counts (default 100,500,1000)\n"
+        "  -j, --threads LIST    thread counts (default 1, 2, 4... up to the cores)\n"
+        "  -k, --chain N         instances in series per strip (default 4)\n"
+        "  -f, --fan-in N        tracks per bus (default 8)\n"
+        "  -b, --block N         block size (default 128)\n"
+        "  -r, --rate HZ         sample rate (default 48000)\n"
+        "  -d, --duration SEC    audio time per configuration (default 2)\n"
+        "  -F, --free            process blocks back to back, not paced\n"
+        "  -m, --memory          show the memory layout of an instance\n"
+        "  -h, --help            show this help\n",
+        program);
+}
+
+template <class T>
+bool parseList(const char* text, std::vector<T>& list) {
+    list.clear();
+    for (const char* p = text; *p;) {
+        char* end;
+        const long value = strtol(p, &end, 10);
+        if (end == p || value < 1)
+            return false;
+        list.push_back((T)value);
+        p = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',')
+            return false;
+    }
+    return !list.empty();
+}
+
+double fromBytes(size_t bytes, const char*& unit) {
+    if (bytes >= (1u << 20)) {
+        unit = "MiB";
+        return bytes / 1048576.0;
+    }
+    unit = "KiB";
+    return bytes / 1024.0;
+}
+
+void printFootprint(const MixerGraph& graph) {
+    const size_t object = graph.getObjectSize();
+    const size_t heap = graph.getHeapSizePerInstance();
+    const size_t buffers = graph.getBufferSizePerInstance();
+    const size_t total = (object + heap + buffers) * graph.getInstanceCount();
+
+    const char* unit;
+    const double size = fromBytes(total, unit);
+    printf("footprint per instance: object %zu B, other heap %zu B, buffers %zu B; working set %.1f %s",
+           object, heap, buffers, size, unit);
+
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    const long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l2 > 0 && l3 > 0) {
+        const char* l2Unit;
+        const char* l3Unit;
+        const double l2Size = fromBytes((size_t)l2, l2Unit);
+        const double l3Size = fromBytes((size_t)l3, l3Unit);
+        printf(" (L2 %.0f %s, L3 %.0f %s)", l2Size, l2Unit, l3Size, l3Unit);
+    }
+#endif
+    printf("\n");
+}
+
+Result simulate(MixerGraph& graph, const Options& options) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.blockSize / options.sampleRate));
+    const uint32_t blocks = (uint32_t)(options.duration * options.sampleRate / options.blockSize);
+
+    // warm the caches and the branch predictors
+    for (unsigned i = 0; i < 16; ++i)
+        graph.process();
+
+    std::vector<double> times;
+    times.reserve(blocks);
+    Result result {};
+    Clock::time_point due = Clock::now();
+
+    for (uint32_t i = 0; i < blocks; ++i) {
+        if (options.paced)
+            std::this_thread::sleep_until(due);
+
+        const Clock::time_point start = Clock::now();
+        graph.process();
+        const Clock::time_point end = Clock::now();
+
+        times.push_back(std::chrono::duration<double>(end - start).count());
+
+        const Clock::time_point deadline = (options.paced ? due : start) + period;
+        if (end > deadline)
+            ++result.misses;
+
+        // after a miss, the host drops the blocks it is late for
+        due += period;
+        if (due < end)
+            due = end;
+    }
+
+    double sum = 0.0;
+    for (double time : times)
+        sum += time;
+    std::sort(times.begin(), times.end());
+    result.blocks = blocks;
+    result.mean = blocks ? sum / blocks : 0.0;
+    result.p99 = blocks ? times[std::min<size_t>(blocks - 1, (size_t)(0.99 * blocks))] : 0.0;
+    result.max = blocks ? times.back() : 0.0;
+    return result;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    const option longOptions[] = {
+        {"instances", required_argument, nullptr, 'n'},
+        {"threads", required_argument, nullptr, 'j'},
+        {"chain", required_argument, nullptr, 'k'},
+        {"fan-in", required_argument, nullptr, 'f'},
+        {"block", required_argument, nullptr, 'b'},
+        {"rate", required_argument, nullptr, 'r'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"free", no_argument, nullptr, 'F'},
+        {"memory", no_argument, nullptr, 'm'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    bool ok = true;
+    for (int c; ok && (c = getopt_long(argc, argv, "n:j:k:f:b:r:d:Fmh", longOptions, nullptr)) != -1;) {
+        switch (c) {
+        case 'n':
+            ok = parseList(optarg, options.instances);
+            break;
+        case 'j':
+            ok = parseList(optarg, options.threads);
+            break;
+        case 'k':
+            options.layout.chainLength = (uint32_t)atoi(optarg);
+            ok = options.layout.chainLength > 0;
+            break;
+        case 'f':
+            options.layout.tracksPerBus = (uint32_t)atoi(optarg);
+            ok = options.layout.tracksPerBus > 0;
+            break;
+        case 'b':
+            options.blockSize = (uint32_t)atoi(optarg);
+            ok = options.blockSize > 0;
+            break;
+        case 'r':
+            options.sampleRate = atof(optarg);
+            ok = options.sampleRate > 0.0;
+            break;
+        case 'd':
+            options.duration = atof(optarg);
+            ok = options.duration > 0.0;
+            break;
+        case 'F':
+            options.paced = false;
+            break;
+        case 'm':
+            options.memoryReport = true;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    if (!ok || optind != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (options.threads.empty()) {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned count = 1; count < cores; count *= 2)
+            options.threads.push_back(count);
+        options.threads.push_back(cores);
+    }
+
+    // hundreds of instances must not each write a trace
+    unsetenv("SIMPLEGAIN_TRACE");
+
+    const double period = options.blockSize / options.sampleRate;
+
+    for (uint32_t instances : options.instances) {
+        MixerGraph::Layout layout = options.layout;
+        layout.instances = instances;
+
+        // the scaling is relative to the first thread count, normally 1
+        double firstMean = 0.0;
+        unsigned firstThreads = 1;
+        for (size_t t = 0; t < options.threads.size(); ++t) {
+            const unsigned threads = options.threads[t];
+            MixerGraph graph(layout, options.sampleRate, options.blockSize, threads);
+
+            if (t == 0) {
+                printf("\ngraph: %u instances, ", graph.getInstanceCount());
+                if (graph.getBusCount() == 0)
+                    printf("a single chain, ");
+                else
+                    printf("%u tracks, %u buses, chains of %u, ",
+                           graph.getTrackCount(), graph.getBusCount(), layout.chainLength);
+                printf("%u frames at %.0f Hz (%.3f ms)\n",
+                       options.blockSize, options.sampleRate, 1e3 * period);
+                printFootprint(graph);
+                if (options.memoryReport && instances == options.instances[0])
+                    graph.getInstance(0).writeMemoryReport(stdout);
+                printf("%7s %8s %8s %8s %8s %8s %10s %12s\n",
+                       "threads", "mean%", "p99%", "max%", "misses", "speedup", "efficiency", "ns/inst-frm");
+            }
+
+            const Result result = simulate(graph, options);
+            if (t == 0) {
+                firstMean = result.mean;
+                firstThreads = threads;
+            }
+            const double speedup = (result.mean > 0.0) ? firstMean / result.mean : 0.0;
+
+            printf("%7u %8.1f %8.1f %8.1f %4u/%-4u %7.2fx %9.0f%% %12.2f\n",
+                   threads, 100.0 * result.mean / period, 100.0 * result.p99 / period,
+                   100.0 * result.max / period, result.misses, result.blocks, speedup,
+                   100.0 * speedup * firstThreads / threads,
+                   1e9 * result.mean / ((double)instances * options.blockSize));
+        }
+    }
+
+    return 0;
+}